@@ -6,6 +6,7 @@
 #include <QFileInfo>
 #include <QTimer>
 #include <iostream>
+#include <signal.h>
 #include <videoprocessor.h>
 #include "mainapplication.h"
 #include "boost/program_options.hpp"
@@ -17,6 +18,8 @@
 namespace po = boost::program_options;
 
 bool verbose = false;
+// Moved to stderr when the frames themselves are written to stdout
+std::ostream* messages = &std::cout;
 
 void debug_output(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
     if (verbose) {
@@ -25,13 +28,13 @@ void debug_output(QtMsgType type, const QMessageLogContext& context, const QStri
             std::cerr << msg.toStdString() << std::endl;
             break;
         case QtWarningMsg:
-            std::cout << msg.toStdString() << std::endl;
+            *messages << msg.toStdString() << std::endl;
             break;
         case QtFatalMsg:
             std::cerr << msg.toStdString() << std::endl;
             break;
         default:
-            std::cout << msg.toStdString() << std::endl;
+            *messages << msg.toStdString() << std::endl;
             break;
         }
     } else {
@@ -39,7 +42,7 @@ void debug_output(QtMsgType type, const QMessageLogContext& context, const QStri
         case QtDebugMsg:
             break;
         case QtWarningMsg:
-            std::cout << msg.toStdString() << std::endl;
+            *messages << msg.toStdString() << std::endl;
             break;
         case QtFatalMsg:
             std::cerr << msg.toStdString() << std::endl;
@@ -64,11 +67,29 @@ int main(int argc, char *argv[])
     string outputPath;
     string cropSize;
     string fdMethod;
+    string orMethod;
+    string eMethod;
+    string motionModel;
     bool salient = false;
     string manualFeatureFilePath;
     bool gravitate = false;
     QRect cropWindow;
-    bool dumpData;
+    bool dumpData = false;
+    bool fused = false;
+    int pathWindow;
+    string pathSolver;
+    double bandedTolerance;
+    bool compareSolvers = false;
+    string lpStrategy;
+    int lpScaling;
+    bool noPresolve = false;
+    string pathCacheDirectory;
+    string outputFormat;
+    string interpolationMethod;
+    bool benchmarkInterpolation = false;
+    bool online = false;
+    int latency;
+    int horizon;
     int radius;
 
     ///////// PROGRAM OPTIONS /////////
@@ -76,10 +97,28 @@ int main(int argc, char *argv[])
     desc.add_options()
             ("help", "produce help message")
             ("input-video,I", po::value<string>(&inputPath)->implicit_value(""),"input video")
-            ("output-video,O", po::value<string>(&outputPath)->implicit_value(""),"output video")
+            ("output-video,O", po::value<string>(&outputPath)->implicit_value(""),"output video (- writes y4m or raw frames to stdout)")
+            ("output-format", po::value<string>(&outputFormat)->implicit_value("video"),"format of the saved videos (video, y4m, raw)")
             ("crop-tl,C", po::value<string>()->implicit_value(""),"coordinates for top left corner of crop window")
             ("crop-size,S", po::value<string>(&cropSize)->implicit_value(""),"cropped window size")
             ("feature-detector,F", po::value<string>(&fdMethod)->implicit_value("goodtt"),"feature detection method")
+            ("outlier-rejector,R", po::value<string>(&orMethod)->implicit_value("local"),"outlier rejection method (local, hierarchical)")
+            ("motion-estimation,E", po::value<string>(&eMethod)->implicit_value("robust"),"global motion estimation method (robust, lsq)")
+            ("motion-model,T", po::value<string>(&motionModel)->implicit_value("affine"),"motion model (translation, similarity, affine)")
+            ("fused", po::value<bool>(&fused)->zero_tokens(),"analyse each frame pair in a single pass, keeping only the motion")
+            ("path-window", po::value<int>(&pathWindow)->default_value(0),"solve the camera path in overlapping windows of this many frames (0 solves the whole video at once)")
+            ("path-solver", po::value<string>(&pathSolver)->implicit_value("clp"),"camera path solver (clp, banded)")
+            ("banded-tolerance", po::value<double>(&bandedTolerance)->default_value(1e-3),"residual per row at which the banded solver stops")
+            ("lp-strategy", po::value<string>(&lpStrategy)->implicit_value("dual"),"LP algorithm used by Clp (dual, primal, barrier without crossover, barrier-crossover)")
+            ("lp-scaling", po::value<int>(&lpScaling)->default_value(1),"Clp scaling mode (0 off, 1 equilibrium, 2 geometric, 3 auto, 4 dynamic)")
+            ("lp-no-presolve", po::value<bool>(&noPresolve)->zero_tokens(),"do not presolve the LP")
+            ("path-cache", po::value<string>(&pathCacheDirectory)->implicit_value(""),"directory caching solved camera paths between runs")
+            ("online", po::value<bool>(&online)->zero_tokens(),"stabilise frames as they arrive, replaying files at their frame rate (input may be a capture device index)")
+            ("latency", po::value<int>(&latency)->default_value(15),"frames of look-ahead before an online frame is emitted")
+            ("horizon", po::value<int>(&horizon)->default_value(0),"most frames optimised at once online (0 uses the whole look-ahead)")
+            ("interpolation", po::value<string>(&interpolationMethod)->implicit_value("bicubic"),"interpolation used to render the new video (nearest, bilinear, bicubic, lanczos)")
+            ("benchmark-interpolation", po::value<bool>(&benchmarkInterpolation)->zero_tokens(),"render the new video with every interpolation and compare their speed and PSNR against bicubic, no video is saved")
+            ("compare-solvers", po::value<bool>(&compareSolvers)->zero_tokens(),"solve the camera path with both solvers and compare them, no video is saved")
             ("feature-window,W", po::value<int>(&radius)->default_value(0),"window around salient feature to search for features")
             ("salient-path-tracking", po::value<bool>(&salient)->zero_tokens(),"enable salient feasture tracking")
             ("manual-features,M", po::value<string>(&manualFeatureFilePath)->implicit_value(""), "file containing manually tracked salient features")
@@ -107,9 +146,34 @@ int main(int argc, char *argv[])
     }
     inputPath = vm["input-video"].as<string>();
 
-    // Process Output Video
+    // Process output format, y4m files are recognised by their extension
     if (vm.count("output-video")==1) {
         outputPath = vm["output-video"].as<string>();
+    }
+    Motion::OUTPUTFORMAT format;
+    if (outputFormat == "y4m" || (outputFormat.empty() && QString::fromStdString(outputPath).endsWith(".y4m"))) {
+        format = Motion::Y4M;
+    } else if (outputFormat == "raw") {
+        format = Motion::RAW;
+    } else {
+        format = Motion::VIDEO;
+    }
+
+    // Process Output Video
+    if (vm.count("output-video")==1) {
+        if (outputPath == "-") {
+            if (format == Motion::VIDEO) {
+                std::cerr << "Only y4m and raw frames can be written to stdout" << std::endl;
+                return 1;
+            }
+            if (dumpData) {
+                std::cerr << "Data can not be dumped next to stdout" << std::endl;
+                return 1;
+            }
+            messages = &std::cerr;
+            // A closed reader is reported as a failed write instead of killing the process
+            signal(SIGPIPE, SIG_IGN);
+        }
     } else {
         QFileInfo fileInfo = QFileInfo(QString::fromStdString(inputPath));
         QString defaultPath = fileInfo.path() + fileInfo.baseName() + "_output.avi";
@@ -166,6 +230,74 @@ int main(int argc, char *argv[])
         fdmethod = Motion::GOODTT;
     }
 
+    // Process outlier rejection method
+    Motion::OUTLIERMETHOD ormethod;
+    if (orMethod == "hierarchical") {
+        ormethod = Motion::HIERARCHICAL;
+    } else {
+        ormethod = Motion::LOCAL;
+    }
+
+    // Process global motion estimation method
+    Motion::ESTIMATIONMETHOD emethod;
+    if (eMethod == "lsq") {
+        emethod = Motion::LEASTSQUARES;
+    } else {
+        emethod = Motion::ROBUST;
+    }
+
+    // Process motion model
+    Motion::MOTIONMODEL model;
+    if (motionModel == "translation") {
+        model = Motion::TRANSLATION;
+    } else if (motionModel == "similarity") {
+        model = Motion::SIMILARITY;
+    } else {
+        model = Motion::AFFINE;
+    }
+
+    // Process path solver
+    Motion::PATHSOLVER solver;
+    if (pathSolver == "banded") {
+        solver = Motion::BANDED;
+    } else {
+        solver = Motion::CLP;
+    }
+
+    if (bandedTolerance <= 0) {
+        std::cerr << "Invalid banded-tolerance given. Should be positive" << std::endl;
+        return 1;
+    }
+
+    if (pathWindow != 0 && pathWindow < 2) {
+        std::cerr << "Invalid path-window given. Should be 0 or at least 2 frames" << std::endl;
+        return 1;
+    }
+
+    // Process LP strategy
+    Motion::LPSTRATEGY strategy;
+    if (lpStrategy == "primal") {
+        strategy = Motion::PRIMAL;
+    } else if (lpStrategy == "barrier") {
+        strategy = Motion::BARRIER;
+    } else if (lpStrategy == "barrier-crossover") {
+        strategy = Motion::BARRIER_CROSSOVER;
+    } else {
+        strategy = Motion::DUAL;
+    }
+
+    // Process interpolation
+    Motion::INTERPOLATION interpolation;
+    if (interpolationMethod == "nearest") {
+        interpolation = Motion::NEAREST;
+    } else if (interpolationMethod == "bilinear") {
+        interpolation = Motion::BILINEAR;
+    } else if (interpolationMethod == "lanczos") {
+        interpolation = Motion::LANCZOS;
+    } else {
+        interpolation = Motion::BICUBIC;
+    }
+
     if (salient) {
         if (!vm.count("manual-features")) {
             std::cerr << "No file for manual features given" << std::endl;
@@ -175,7 +307,35 @@ int main(int argc, char *argv[])
     }
 
     qWarning() << "Starting core application";
-    MainApplication* main = new MainApplication(QString::fromStdString(inputPath), QString::fromStdString(outputPath), cropWindow, fdmethod, salient, radius, QString::fromStdString(manualFeatureFilePath),gravitate,dumpData, &a);
+    Motion::Options options;
+    options.src = QString::fromStdString(inputPath);
+    options.dst = QString::fromStdString(outputPath);
+    options.cropbox = cropWindow;
+    options.fdmethod = fdmethod;
+    options.ormethod = ormethod;
+    options.emethod = emethod;
+    options.model = model;
+    options.fused = fused;
+    options.pathWindow = pathWindow;
+    options.solver = solver;
+    options.bandedTolerance = bandedTolerance;
+    options.strategy = strategy;
+    options.scaling = lpScaling;
+    options.presolve = !noPresolve;
+    options.pathCache = QString::fromStdString(pathCacheDirectory);
+    options.compareSolvers = compareSolvers;
+    options.online = online;
+    options.latency = latency;
+    options.horizon = horizon;
+    options.format = format;
+    options.interpolation = interpolation;
+    options.benchmarkInterpolation = benchmarkInterpolation;
+    options.salient = salient;
+    options.window = radius;
+    options.salientDetails = QString::fromStdString(manualFeatureFilePath);
+    options.gravitate = gravitate;
+    options.dumpData = dumpData;
+    MainApplication* main = new MainApplication(options, &a);
     QObject::connect(main, SIGNAL(quit()), &a, SLOT(quit()));
     QTimer::singleShot(0, main, SLOT(run()));
     return a.exec();
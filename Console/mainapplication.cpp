@@ -11,15 +11,15 @@
 #include <QFileInfo>
 #include <QDir>
 
-MainApplication::MainApplication(QString src, QString dst, QRect cropbox, Motion::FEATUREDMETHOD fdmethod, bool salient, int window, QString salientDetails, bool gravitate, bool dumpData, QObject *parent)
-    : QObject(parent),src(src),dst(dst),cropbox(cropbox), fdmethod(fdmethod), salient(salient),window(window), salientDetails(salientDetails), gravitate(gravitate),dumpData(dumpData)
+MainApplication::MainApplication(const Motion::Options& options, QObject *parent)
+    : QObject(parent), options(options)
 {
     QObject::connect(&coreApp, SIGNAL(processProgressChanged(float)), this, SLOT(processProgressChanged(float)));
 }
 
 void MainApplication::run()
 {
-    switch (fdmethod) {
+    switch (options.fdmethod) {
     case Motion::GOODTT:
         coreApp.setGFTTDetector();
         break;
@@ -40,34 +40,150 @@ void MainApplication::run()
         break;
     }
 
+    switch (options.ormethod) {
+    case Motion::HIERARCHICAL:
+        coreApp.setHierarchicalOutlierRejector();
+        break;
+    default:
+        coreApp.setLocalOutlierRejector();
+        break;
+    }
+
+    switch (options.emethod) {
+    case Motion::LEASTSQUARES:
+        coreApp.setLeastSquaresMotionEstimation();
+        break;
+    default:
+        coreApp.setRobustMotionEstimation();
+        break;
+    }
+
+    switch (options.model) {
+    case Motion::TRANSLATION:
+        coreApp.setTranslationModel();
+        break;
+    case Motion::SIMILARITY:
+        coreApp.setSimilarityModel();
+        break;
+    default:
+        coreApp.setAffineModel();
+        break;
+    }
+    coreApp.setFusedAnalysis(options.fused);
+    if (!coreApp.setPathWindow(options.pathWindow)) {
+        emit quit();
+        return;
+    }
+    switch (options.solver) {
+    case Motion::BANDED:
+        coreApp.setBandedPathSolver();
+        break;
+    default:
+        coreApp.setClpPathSolver();
+        break;
+    }
+
+    switch (options.strategy) {
+    case Motion::PRIMAL:
+        coreApp.setSolverStrategy(L1Model::PRIMAL);
+        break;
+    case Motion::BARRIER:
+        coreApp.setSolverStrategy(L1Model::BARRIER);
+        break;
+    case Motion::BARRIER_CROSSOVER:
+        coreApp.setSolverStrategy(L1Model::BARRIER_CROSSOVER);
+        break;
+    default:
+        coreApp.setSolverStrategy(L1Model::DUAL);
+        break;
+    }
+    coreApp.setSolverScaling(options.scaling);
+    coreApp.setSolverPresolve(options.presolve);
+    coreApp.setBandedTolerance(options.bandedTolerance);
+    coreApp.setPathCacheDirectory(options.pathCache);
+
+    switch (options.format) {
+    case Motion::Y4M:
+        coreApp.setY4MOutput();
+        break;
+    case Motion::RAW:
+        coreApp.setRawOutput();
+        break;
+    default:
+        coreApp.setVideoOutput();
+        break;
+    }
+
+    switch (options.interpolation) {
+    case Motion::NEAREST:
+        coreApp.setNearestInterpolation();
+        break;
+    case Motion::BILINEAR:
+        coreApp.setBilinearInterpolation();
+        break;
+    case Motion::LANCZOS:
+        coreApp.setLanczosInterpolation();
+        break;
+    default:
+        coreApp.setBicubicInterpolation();
+        break;
+    }
+
+    if (options.online) {
+        qWarning() << "Stabilising online with a latency of" << options.latency << "frames";
+        coreApp.stabiliseOnline(options.src, options.dst, options.cropbox, options.latency, options.horizon);
+        qWarning() << "Finished";
+        emit quit();
+        return;
+    }
+
     qWarning() << "Starting run";
     Video* video;
     qWarning() << "Loading original video";
-    video = coreApp.loadOriginalVideo(src);
-    video->setCropBox(cropbox.x(), cropbox.y(), cropbox.width(), cropbox.height());
+    video = coreApp.loadOriginalVideo(options.src);
+    video->setCropBox(options.cropbox.x(), options.cropbox.y(), options.cropbox.width(), options.cropbox.height());
     qWarning() << "Calculating motion in original video";
-    coreApp.calculateOriginalMotion(window);
-    if (salient) {
+    coreApp.calculateOriginalMotion(options.window);
+    if (options.compareSolvers) {
+        qWarning() << "Comparing path solvers";
+        coreApp.compareSolvers();
+        qWarning() << "Finished";
+        emit quit();
+        return;
+    }
+    if (options.salient) {
         qWarning() << "Loading manual markings for salient feature";
-        coreApp.loadFeatures(salientDetails);
-        qWarning() << "Calculating new video, preserving salient feature";
-        coreApp.calculateNewMotion(salient, gravitate);
+        coreApp.loadFeatures(options.salientDetails);
+        qWarning() << "Calculating new path, preserving salient feature";
+        coreApp.calculateNewPath(options.salient, options.gravitate);
+    } else {
+        qWarning() << "Calculating new path";
+        coreApp.calculateNewPath(false, false);
+    }
+    if (options.benchmarkInterpolation) {
+        qWarning() << "Benchmarking interpolations";
+        coreApp.benchmarkInterpolation();
+        qWarning() << "Finished";
+        emit quit();
+        return;
+    }
+    // All videos are written in one pass over the original frames
+    QFileInfo file(options.dst);
+    QString directory = file.path()+"/";
+    QString oldCroppedVideoPath;
+    if (options.dumpData) {
+        qWarning() << "Saving new video and original cropped video";
+        QString extension = options.format == Motion::Y4M ? ".y4m" : (options.format == Motion::RAW ? ".bgr" : ".avi");
+        oldCroppedVideoPath = directory+file.baseName()+"_original"+extension;
     } else {
-        qWarning() << "Calculating new video";
-        coreApp.calculateNewMotion(false, false);
+        qWarning() << "Saving new video";
     }
-    qWarning() << "Saving new video";
-    coreApp.saveNewVideo(dst);
-    if (dumpData) {
-        QFileInfo file(dst);
-        QString directory = file.path()+"/";
+    coreApp.exportVideos(options.dst, oldCroppedVideoPath, "");
+    if (options.dumpData) {
         QString matPath = directory+file.baseName()+".mat";
         qWarning() << "Saving MATLAB .mat files to " << matPath;
         coreApp.saveOriginalGlobalMotionMat(matPath);
         coreApp.saveNewGlobalMotionMat(matPath);
-        qWarning() << "Saving Original Cropped Video";
-        QString oldCroppedVideoPath = directory+file.baseName()+"_original"+".avi";
-        coreApp.saveCroppedOldVideo(oldCroppedVideoPath);
     }
     qWarning() << "Finished";
     emit quit();
@@ -10,6 +10,44 @@
 
 namespace Motion {
     enum FEATUREDMETHOD {GOODTT, GOODTTH, SIFT, FAST, SURF};
+    enum OUTLIERMETHOD {LOCAL, HIERARCHICAL};
+    enum ESTIMATIONMETHOD {ROBUST, LEASTSQUARES};
+    enum MOTIONMODEL {TRANSLATION, SIMILARITY, AFFINE};
+    enum PATHSOLVER {CLP, BANDED};
+    enum LPSTRATEGY {DUAL, PRIMAL, BARRIER, BARRIER_CROSSOVER};
+    enum OUTPUTFORMAT {VIDEO, Y4M, RAW};
+    enum INTERPOLATION {NEAREST, BILINEAR, BICUBIC, LANCZOS};
+
+    // Everything given on the command line
+    struct Options {
+        QString src;
+        QString dst;
+        QRect cropbox;
+        FEATUREDMETHOD fdmethod;
+        OUTLIERMETHOD ormethod;
+        ESTIMATIONMETHOD emethod;
+        MOTIONMODEL model;
+        bool fused;
+        int pathWindow;
+        PATHSOLVER solver;
+        double bandedTolerance;
+        LPSTRATEGY strategy;
+        int scaling;
+        bool presolve;
+        QString pathCache;
+        bool compareSolvers;
+        bool online;
+        int latency;
+        int horizon;
+        OUTPUTFORMAT format;
+        INTERPOLATION interpolation;
+        bool benchmarkInterpolation;
+        bool salient;
+        int window;
+        QString salientDetails;
+        bool gravitate;
+        bool dumpData;
+    };
 }
 
 class MainApplication : public QObject
@@ -17,7 +55,7 @@ class MainApplication : public QObject
     Q_OBJECT
 
 public:
-    explicit MainApplication(QString src, QString dst, QRect cropbox, Motion::FEATUREDMETHOD fdmethod, bool salient, int window, QString salientDetails, bool gravitate, bool dumpData, QObject *parent = 0);
+    explicit MainApplication(const Motion::Options& options, QObject *parent = 0);
 
 signals:
     void quit();
@@ -29,15 +67,7 @@ public slots:
 private:
     CoreApplication coreApp;
 
-    QString src;
-    QString dst;
-    QRect cropbox;
-    Motion::FEATUREDMETHOD fdmethod;
-    bool salient;
-    int window;
-    QString salientDetails;
-    bool gravitate;
-    bool dumpData;
+    Motion::Options options;
 
 };
 
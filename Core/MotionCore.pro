@@ -20,7 +20,18 @@ SOURCES += videoprocessor.cpp \
     l1model.cpp \
     evaluator.cpp \
     coreapplication.cpp \
-    l1salientmodel.cpp
+    l1salientmodel.cpp \
+    outlierrejector.cpp \
+    hierarchicalransacrejector.cpp \
+    motionestimator.cpp \
+    l1bandedmodel.cpp \
+    l1translationmodel.cpp \
+    pathcache.cpp \
+    onlinestabiliser.cpp \
+    framesink.cpp \
+    asyncwriter.cpp \
+    exportplanner.cpp \
+    lazyvideo.cpp
 
 HEADERS += videoprocessor.h \
     video.h \
@@ -32,7 +43,18 @@ HEADERS += videoprocessor.h \
     l1model.h \
     evaluator.h \
     coreapplication.h \
-    l1salientmodel.h
+    l1salientmodel.h \
+    outlierrejector.h \
+    hierarchicalransacrejector.h \
+    motionestimator.h \
+    l1bandedmodel.h \
+    l1translationmodel.h \
+    pathcache.h \
+    onlinestabiliser.h \
+    framesink.h \
+    asyncwriter.h \
+    exportplanner.h \
+    lazyvideo.h
 
 macx {
     # OPENCV Library
@@ -0,0 +1,53 @@
+#include "asyncwriter.h"
+#include <QMutexLocker>
+
+AsyncWriter::AsyncWriter(FrameSink* sink, int capacity) :
+    QThread(), sink(sink), capacity(capacity), closing(false)
+{
+    start();
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    close();
+    delete sink;
+}
+
+void AsyncWriter::write(const Mat& image)
+{
+    QMutexLocker locker(&mutex);
+    while (queue.size() >= capacity) {
+        notFull.wait(&mutex);
+    }
+    queue.enqueue(image);
+    notEmpty.wakeOne();
+}
+
+void AsyncWriter::close()
+{
+    {
+        QMutexLocker locker(&mutex);
+        closing = true;
+        notEmpty.wakeOne();
+    }
+    wait();
+}
+
+void AsyncWriter::run()
+{
+    while (true) {
+        Mat image;
+        {
+            QMutexLocker locker(&mutex);
+            while (queue.isEmpty() && !closing) {
+                notEmpty.wait(&mutex);
+            }
+            if (queue.isEmpty()) {
+                return;
+            }
+            image = queue.dequeue();
+            notFull.wakeOne();
+        }
+        sink->write(image);
+    }
+}
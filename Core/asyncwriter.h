@@ -0,0 +1,47 @@
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include "framesink.h"
+
+/*
+ *
+ *  Runs a sink, usually an encoder, on its own thread. Frames are
+ *  queued and written in order, and write only blocks while the
+ *  queue is full, so producing and encoding frames overlap.
+ *
+ */
+class AsyncWriter : public QThread, public FrameSink
+{
+public:
+    // Takes ownership of the sink
+    explicit AsyncWriter(FrameSink* sink, int capacity = 8);
+
+    // Writes the remaining frames first
+    ~AsyncWriter();
+
+    bool isOpened() const {return sink->isOpened();}
+
+    // The image is queued without copying it, so it must not be changed afterwards
+    void write(const Mat& image);
+
+    // Blocks until every queued frame has been written
+    void close();
+
+protected:
+    void run();
+
+private:
+    FrameSink* sink;
+    int capacity;
+    QQueue<Mat> queue;
+    QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    bool closing;
+};
+
+#endif // ASYNCWRITER_H
@@ -4,6 +4,10 @@
 #include <QFileInfo>
 #include <QDir>
 #include "frame.h"
+#include "onlinestabiliser.h"
+#include "asyncwriter.h"
+#include "exportplanner.h"
+#include "lazyvideo.h"
 
 CoreApplication::CoreApplication(QObject *parent) :
     QObject(parent)
@@ -12,6 +16,8 @@ CoreApplication::CoreApplication(QObject *parent) :
     QObject::connect(this, SIGNAL(registerMatlabFunctionPath(QString)), &ev, SLOT(addFunctionLocationToPath(QString)));
     originalVideo = 0;
     newVideo = 0;
+    fusedAnalysis = false;
+    outputFormat = VIDEO_OUTPUT;
 }
 
 Video* CoreApplication::loadOriginalVideo(QString path)
@@ -26,7 +32,7 @@ Video* CoreApplication::loadOriginalVideo(QString path)
     }
     // Load Video
     int frameCount = vc.get(CV_CAP_PROP_FRAME_COUNT);
-    int fps = vc.get(CV_CAP_PROP_FPS);
+    double fps = vc.get(CV_CAP_PROP_FPS);
     originalVideo = new Video(frameCount,fps);
     QFileInfo fileInfo = QFileInfo(path);
     originalVideo->setVideoName(fileInfo.fileName());
@@ -54,66 +60,106 @@ Video* CoreApplication::loadOriginalVideo(QString path)
 void CoreApplication::saveNewVideo(QString path)
 {
     emit processStatusChanged(CoreApplication::SAVE_VIDEO, true);
-    VideoWriter record(path.toStdString(), videoFourCCCodec,25, newVideo->getSize());
+    AsyncWriter record(openSink(path, newVideo->getSize(), videoFourCCCodec, originalVideo->getOrigFps()));
     assert(record.isOpened());
     for (int f = 0; f < newVideo->getFrameCount(); f++) {
         emit processProgressChanged((float)f/newVideo->getFrameCount());
-        const Frame* frame = newVideo->getFrameAt(f);
-        Mat img = frame->getOriginalData().clone();
-        record << img;
+        record.write(newVideo->getImageAt(f));
+    }
+    record.close();
+    if (!record.isOpened()) {
+        qWarning() << "Could not write" << path;
     }
     emit processStatusChanged(CoreApplication::SAVE_VIDEO, false);
 }
 
 void CoreApplication::saveOldVideo(QString path) {
+    exportVideos("", "", path);
+}
+
+void CoreApplication::saveCroppedOldVideo(QString path)
+{
+    exportVideos("", path, "");
+}
+
+void CoreApplication::exportVideos(QString stabilisedPath, QString croppedPath, QString overlayPath)
+{
     emit processStatusChanged(CoreApplication::SAVE_VIDEO, true);
-    VideoWriter record(path.toStdString(), videoFourCCCodec,25,originalVideo->getSize());
-    assert(record.isOpened());
-    for (int f = 0; f < originalVideo->getFrameCount(); f++) {
-        emit processProgressChanged((float)f/originalVideo->getFrameCount());
-        const Frame* frame = originalVideo->getFrameAt(f);
-        Mat image = frame->getOriginalData().clone();
-        const Rect_<int>& cropBox = originalVideo->getCropBox();
-        if (f == 0) {
-            cv::rectangle(image, cropBox, Scalar(0,255,0), 3);
-        } else {
-            const Mat& update = frame->getUpdateTransform();
-            RotatedRect newCrop = Tools::transformRectangle(update, cropBox);
-            Point2f verts[4];
-            newCrop.points(verts);
-            for (int i = 0; i < 4; i++) {
-                line(image, verts[i], verts[(i+1)%4], Scalar(0,255,0),3);
-            }
+    ExportPlanner planner;
+    QObject::connect(&planner, SIGNAL(processProgressChanged(float)), this, SIGNAL(processProgressChanged(float)));
+    planner.setInterpolation(vp.getInterpolation());
+    Size croppedSize = originalVideo->getCropBox().size();
+    double fps = originalVideo->getOrigFps();
+    QList<AsyncWriter*> writers;
+    QStringList paths;
+    if (!stabilisedPath.isEmpty()) {
+        writers.append(new AsyncWriter(openSink(stabilisedPath, croppedSize, videoFourCCCodec, fps)));
+        planner.addVideo(ExportPlanner::STABILISED, writers.last());
+        paths.append(stabilisedPath);
+    }
+    if (!croppedPath.isEmpty()) {
+        writers.append(new AsyncWriter(openSink(croppedPath, croppedSize, videoFourCCCodec, fps)));
+        planner.addVideo(ExportPlanner::CROPPED, writers.last());
+        paths.append(croppedPath);
+    }
+    if (!overlayPath.isEmpty()) {
+        writers.append(new AsyncWriter(openSink(overlayPath, originalVideo->getSize(), videoFourCCCodec, fps)));
+        planner.addVideo(ExportPlanner::OVERLAY, writers.last());
+        paths.append(overlayPath);
+    }
+    planner.run(originalVideo);
+    for (int i = 0; i < writers.size(); i++) {
+        // Waits for the encoder to finish
+        writers[i]->close();
+        if (!writers[i]->isOpened()) {
+            qWarning() << "Could not write" << paths[i];
         }
-        record << image;
     }
+    qDeleteAll(writers);
     emit processStatusChanged(CoreApplication::SAVE_VIDEO, false);
 }
 
-void CoreApplication::saveCroppedOldVideo(QString path)
+FrameSink* CoreApplication::openSink(QString path, Size size, int fourCC, double fps)
 {
-    emit processStatusChanged(CoreApplication::SAVE_VIDEO, true);
-    //qDebug() << "Saving cropped video " << originalVideo->getCropBox().size().width << "," << originalVideo->getCropBox().size().height;
-    Size croppedSize(originalVideo->getCropBox().size().width, originalVideo->getCropBox().size().height);
-
-    VideoWriter record(path.toStdString(), videoFourCCCodec,25,croppedSize);
-    assert(record.isOpened());
-    for (int f = 0; f < originalVideo->getFrameCount(); f++) {
-        emit processProgressChanged((float)f/originalVideo->getFrameCount());
-        const Frame* frame = originalVideo->getFrameAt(f);
-        Mat originalData = frame->getOriginalData();
-        Mat croppedImage;
-        Rect cropBox = originalVideo->getCropBox();
-        Mat(originalData, cropBox).copyTo(croppedImage);
-        record << croppedImage;
+    // Not every container reports its frame rate
+    if (fps <= 0) {
+        fps = 25;
     }
-    emit processStatusChanged(CoreApplication::SAVE_VIDEO, false);
+    FrameSink* sink;
+    switch (outputFormat) {
+    case Y4M_OUTPUT:
+        sink = new Y4MSink(path, fps, size);
+        break;
+    case RAW_OUTPUT:
+        // The frames have no header, so whatever reads them needs to be told their format
+        qWarning() << "Writing" << size.width << "x" << size.height << "BGR frames at" << fps << "fps to" << path;
+        sink = new RawSink(path);
+        break;
+    default:
+        sink = new VideoWriterSink(path, fourCC, fps, size);
+        break;
+    }
+    assert(sink->isOpened());
+    return sink;
 }
 
 
 void CoreApplication::calculateOriginalMotion(int radius)
 {
     originalVideo->reset();
+    if (fusedAnalysis) {
+        // All stages run together, so they start and finish together
+        emit processStatusChanged(CoreApplication::FEATURE_DETECTION, true);
+        emit processStatusChanged(CoreApplication::FEATURE_TRACKING, true);
+        emit processStatusChanged(CoreApplication::OUTLIER_REJECTION, true);
+        emit processStatusChanged(CoreApplication::ORIGINAL_MOTION, true);
+        vp.analyseFramePairs(originalVideo, radius, false);
+        emit processStatusChanged(CoreApplication::FEATURE_DETECTION, false);
+        emit processStatusChanged(CoreApplication::FEATURE_TRACKING, false);
+        emit processStatusChanged(CoreApplication::OUTLIER_REJECTION, false);
+        emit processStatusChanged(CoreApplication::ORIGINAL_MOTION, false);
+        return;
+    }
     emit processStatusChanged(CoreApplication::FEATURE_DETECTION, true);
     vp.detectFeatures(originalVideo, radius);
     emit processStatusChanged(CoreApplication::FEATURE_DETECTION, false);
@@ -129,6 +175,22 @@ void CoreApplication::calculateOriginalMotion(int radius)
 }
 
 void CoreApplication::calculateNewMotion(bool salient, bool centered)
+{
+    // The previous video renders from the path about to be replaced, so it is
+    // stopped first. It may still be shown, so the GUI deletes it once it shows
+    // the new video
+    if (newVideo != 0) {
+        newVideo->stop();
+    }
+    calculateNewPath(salient, centered);
+    emit processStatusChanged(CoreApplication::NEW_VIDEO, true);
+    // Frames are rendered as they are shown or saved
+    newVideo = new LazyVideo(originalVideo, vp.getInterpolation());
+    emit newVideoCreated(newVideo);
+    emit processStatusChanged(CoreApplication::NEW_VIDEO, false);
+}
+
+void CoreApplication::calculateNewPath(bool salient, bool centered)
 {
     emit processStatusChanged(CoreApplication::NEW_MOTION, true);
     if (!salient) {
@@ -137,11 +199,11 @@ void CoreApplication::calculateNewMotion(bool salient, bool centered)
         vp.calculateSalientUpdateTransform(originalVideo,centered);
     }
     emit processStatusChanged(CoreApplication::NEW_MOTION, false);
-    emit processStatusChanged(CoreApplication::NEW_VIDEO, true);
-    newVideo = new Video(originalVideo->getFrameCount());
-    vp.applyCropTransform(originalVideo, newVideo);
-    emit newVideoCreated(newVideo);
-    emit processStatusChanged(CoreApplication::NEW_VIDEO, false);
+}
+
+void CoreApplication::streamNewVideo(QString path)
+{
+    exportVideos(path, "", "");
 }
 
 
@@ -167,27 +229,20 @@ void CoreApplication::setOriginalPointMotion(QMap<int, QPoint> locations) {
 
 void CoreApplication::drawGraph(bool usePointOriginal, bool showOriginal, bool showNew, bool x, bool y)
 {
-    // Build Original Path Object
-    QList<Mat> original;
+    // Original Path, read straight from the video
+    int frames = originalVideo->getFrameCount()-1;
+    Mat original;
     if (!usePointOriginal) {
-        for (int f = 1; f < originalVideo->getFrameCount(); f++) {
-            Frame* frame = originalVideo->accessFrameAt(f);
-            const Mat& aff = frame->getAffineTransform();
-            original.push_back(aff);
-        }
+        original = originalVideo->getAffineTransforms(1, frames);
     } else {
         qDebug() << "CoreApplication::drawGraph - Not yet compatible with originalPoint";
         return;
     }
 
-    // Build Update Transform Object
-    QList<Mat> update;
+    // Update Transforms
+    Mat update;
     if (showNew) {
-        for (int f = 1; f < originalVideo->getFrameCount(); f++) {
-            Frame* frame = originalVideo->accessFrameAt(f);
-            const Mat& aff = frame->getUpdateTransform();
-            update.push_back(aff);
-        }
+        update = originalVideo->getUpdateTransforms(1, frames);
     }
 
     if (showNew) {
@@ -199,28 +254,22 @@ void CoreApplication::drawGraph(bool usePointOriginal, bool showOriginal, bool s
 
 void CoreApplication::saveOriginalGlobalMotionMat(QString path) {
     qDebug() << "Saving original motion to Matlab";
-    QList<Mat> matrices;
-    for (int f = 1; f < originalVideo->getFrameCount(); f++) {
-        Frame* frame = originalVideo->accessFrameAt(f);
-        matrices.push_back(frame->getAffineTransform());
-    }
-    ev.exportMatrices(matrices, path, "originalGlobalMotion");
+    ev.exportMatrices(originalVideo->getAffineTransforms(1, originalVideo->getFrameCount()-1), path, "originalGlobalMotion");
 }
 
 void CoreApplication::saveNewGlobalMotionMat(QString path) {
     qDebug() << "Saving new motion to Matlab";
-    QList<Mat> matrices;
-    for (int f = 1; f < originalVideo->getFrameCount(); f++) {
-        Frame* frame = originalVideo->accessFrameAt(f);
-        matrices.push_back(frame->getUpdateTransform());
-    }
-    ev.exportMatrices(matrices, path, "newGlobalMotion");
+    ev.exportMatrices(originalVideo->getUpdateTransforms(1, originalVideo->getFrameCount()-1), path, "newGlobalMotion");
 }
 
 
 void CoreApplication::clear() {
-    delete(originalVideo);
+    // The new video renders from the original video
     delete(newVideo);
+    delete(originalVideo);
+    newVideo = 0;
+    originalVideo = 0;
+    vp.discardPathModels();
     originalPointMotion.clear();
 }
 
@@ -244,6 +293,131 @@ void CoreApplication::setGFTTHDetector() {
     vp.setGFTTHDetector();
 }
 
+void CoreApplication::setLocalOutlierRejector() {
+    vp.setLocalRejector();
+}
+
+void CoreApplication::setHierarchicalOutlierRejector() {
+    vp.setHierarchicalRejector();
+}
+
+void CoreApplication::setRobustMotionEstimation() {
+    vp.setRobustMotionEstimation();
+}
+
+void CoreApplication::setLeastSquaresMotionEstimation() {
+    vp.setLeastSquaresMotionEstimation();
+}
+
+void CoreApplication::setTranslationModel() {
+    vp.setTranslationModel();
+}
+
+void CoreApplication::setSimilarityModel() {
+    vp.setSimilarityModel();
+}
+
+void CoreApplication::setAffineModel() {
+    vp.setAffineModel();
+}
+
+void CoreApplication::setVideoOutput() {
+    outputFormat = VIDEO_OUTPUT;
+}
+
+void CoreApplication::setY4MOutput() {
+    outputFormat = Y4M_OUTPUT;
+}
+
+void CoreApplication::setRawOutput() {
+    outputFormat = RAW_OUTPUT;
+}
+
+void CoreApplication::setFusedAnalysis(bool fused) {
+    fusedAnalysis = fused;
+}
+
+// Neighbouring windows share a fifth of their frames
+bool CoreApplication::setPathWindow(int windowSize) {
+    return vp.setPathWindow(windowSize, windowSize/5);
+}
+
+void CoreApplication::setClpPathSolver() {
+    vp.setClpPathSolver();
+}
+
+void CoreApplication::setBandedPathSolver() {
+    vp.setBandedPathSolver();
+}
+
+void CoreApplication::setNearestInterpolation() {
+    vp.setNearestInterpolation();
+}
+
+void CoreApplication::setBilinearInterpolation() {
+    vp.setBilinearInterpolation();
+}
+
+void CoreApplication::setBicubicInterpolation() {
+    vp.setBicubicInterpolation();
+}
+
+void CoreApplication::setLanczosInterpolation() {
+    vp.setLanczosInterpolation();
+}
+
+void CoreApplication::setSolverStrategy(L1Model::Strategy strategy) {
+    vp.setSolverStrategy(strategy);
+}
+
+void CoreApplication::setPathCacheDirectory(QString directory) {
+    vp.setPathCacheDirectory(directory);
+}
+
+void CoreApplication::setSolverScaling(int scaling) {
+    vp.setSolverScaling(scaling);
+}
+
+void CoreApplication::setSolverPresolve(bool presolve) {
+    vp.setSolverPresolve(presolve);
+}
+
+void CoreApplication::setBandedTolerance(double tolerance) {
+    vp.setBandedTolerance(tolerance);
+}
+
+double CoreApplication::compareSolvers() {
+    return vp.compareSolvers(originalVideo);
+}
+
+void CoreApplication::benchmarkInterpolation() {
+    vp.benchmarkInterpolation(originalVideo);
+}
+
+void CoreApplication::stabiliseOnline(QString source, QString path, QRect cropBox, int latency, int horizon) {
+    OnlineStabiliser stabiliser(&vp);
+    if (!stabiliser.open(source)) {
+        qWarning() << "Could not open" << source;
+        return;
+    }
+    stabiliser.setCropBox(Rect(cropBox.x(), cropBox.y(), cropBox.width(), cropBox.height()));
+    stabiliser.setLatency(latency);
+    stabiliser.setHorizon(horizon);
+    AsyncWriter record(openSink(path, Size(cropBox.width(), cropBox.height()), stabiliser.getFourCC(), stabiliser.getFps()));
+    assert(record.isOpened());
+    stabiliser.setSink(&record);
+    emit processStatusChanged(CoreApplication::NEW_VIDEO, true);
+    stabiliser.run();
+    record.close();
+    if (!record.isOpened()) {
+        qWarning() << "Could not write" << path;
+    }
+    emit processStatusChanged(CoreApplication::NEW_VIDEO, false);
+    qWarning() << "Stabilised" << stabiliser.getEmittedFrames() << "frames at" << stabiliser.getFps() << "fps";
+    qWarning() << "Latency mean" << stabiliser.getMeanLatency() << "ms, max" << stabiliser.getMaxLatency()
+               << "ms, of which" << latency * 1000 / stabiliser.getFps() << "ms is look-ahead";
+}
+
 void CoreApplication::loadFeatures(QString path) {
     QMap<int, Point2f*> locations;
     QFile file(path);
@@ -264,29 +438,19 @@ void CoreApplication::loadFeatures(QString path) {
         Frame* f = originalVideo->accessFrameAt(i.key());
         f->setFeature(i.value());
     }
+    // The salient constraints were built from the old features
+    vp.discardPathModels();
 }
 
 void CoreApplication::saveOriginalFrame(QString path, int frame, bool cropped){
-    const Frame* f = originalVideo->getFrameAt(frame);
-    const Mat& originalData = f->getOriginalData();
-    if (cropped) {
-        Mat cropped = originalData(originalVideo->getCropBox());
-        cv::imwrite(path.toStdString(), cropped);
-    } else {
-        cv::imwrite(path.toStdString(), originalData);
-    }
+    ExportPlanner planner;
+    planner.addFrame(cropped ? ExportPlanner::CROPPED : ExportPlanner::ORIGINAL, frame, path);
+    planner.run(originalVideo);
 }
 
 void CoreApplication::saveNewFrame(QString path, int frame) {
-    if (frame == 0) {
-        saveOriginalFrame(path, frame, true);
-        return;
-    }
-    const Frame* f = originalVideo->getFrameAt(frame);
-    const Mat& originalData = f->getOriginalData();
-    const Rect& cropBox = originalVideo->getCropBox();
-    RotatedRect newCropWindow = Tools::transformRectangle(f->getUpdateTransform(), cropBox);
-    Mat newImage = Tools::getCroppedImage(originalData, newCropWindow);
-    resize(newImage,newImage,cropBox.size());
-    cv::imwrite(path.toStdString(), newImage);
+    ExportPlanner planner;
+    planner.setInterpolation(vp.getInterpolation());
+    planner.addFrame(ExportPlanner::STABILISED, frame, path);
+    planner.run(originalVideo);
 }
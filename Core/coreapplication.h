@@ -4,8 +4,11 @@
 #include <QObject>
 #include "videoprocessor.h"
 #include "evaluator.h"
+#include "asyncwriter.h"
 #include <QMap>
 
+class LazyVideo;
+
 /*
  *
  * This is the entry object into the core framework.
@@ -34,6 +37,8 @@ signals:
     void processStatusChanged(int,bool);
     void processProgressChanged(float);
     void originalVideoLoaded(Video* video);
+    // The previous new video is stopped, and is deleted by the receiver once
+    // it no longer shows it
     void newVideoCreated(Video* video);
     void registerMatlabFunctionPath(QString);
     
@@ -45,6 +50,9 @@ public slots:
     void calculateOriginalMotion(int radius);
     void calculateNewMotion(bool salient, bool centered);
 
+    // Only calculates the update transforms, without creating the new video
+    void calculateNewPath(bool salient, bool centered);
+
     // Evaluate Results
     void evaluateNewMotion();
     void drawGraph(bool usePointOriginal, bool showOriginal, bool showNew, bool x, bool y);
@@ -52,6 +60,14 @@ public slots:
 
     // Output
     void saveNewVideo(QString path);
+
+    // Renders the new video straight into the file, without keeping its frames.
+    // Pre: calculateNewPath has been called
+    void streamNewVideo(QString path);
+
+    // Writes the stabilised, cropped original and crop overlay videos in a single
+    // pass over the original frames. Outputs with an empty path are skipped
+    void exportVideos(QString stabilisedPath, QString croppedPath, QString overlayPath);
     void saveCroppedOldVideo(QString path);
     void saveOldVideo(QString path);
 
@@ -69,16 +85,56 @@ public slots:
     void setSIFTDetector();
     void setFASTDetector();
     void setGFTTHDetector();
+    void setLocalOutlierRejector();
+    void setHierarchicalOutlierRejector();
+    void setRobustMotionEstimation();
+    void setLeastSquaresMotionEstimation();
+    void setTranslationModel();
+    void setSimilarityModel();
+    void setAffineModel();
+    void setFusedAnalysis(bool fused);
+
+    // Format of the saved videos. Y4M and raw frames are written to stdout for a path of "-"
+    void setVideoOutput();
+    void setY4MOutput();
+    void setRawOutput();
+    // Windows are 0 (the whole video) or at least 2 frames, false otherwise
+    bool setPathWindow(int windowSize);
+    void setClpPathSolver();
+    void setBandedPathSolver();
+    void setNearestInterpolation();
+    void setBilinearInterpolation();
+    void setBicubicInterpolation();
+    void setLanczosInterpolation();
+    void setSolverStrategy(L1Model::Strategy strategy);
+    void setPathCacheDirectory(QString directory);
+    void setSolverScaling(int scaling);
+    void setSolverPresolve(bool presolve);
+    void setBandedTolerance(double tolerance);
+
+    // Solves the path of the original video with both solvers, returns the relative objective gap
+    double compareSolvers();
+
+    // Reports the render speed and quality of each interpolation against bicubic
+    // Pre: calculateNewPath has been called
+    void benchmarkInterpolation();
+
+    // Stabilises a capture device or a file replayed at its frame rate as the frames
+    // arrive, saving each crop latency frames later. Reports the end to end latency
+    void stabiliseOnline(QString source, QString path, QRect cropBox, int latency, int horizon);
 
 
 private:
     // Objects Handled
     Video* originalVideo;
-    Video* newVideo;
+    LazyVideo* newVideo;
 
     // The codec of the last video read in
     int videoFourCCCodec;
 
+    // Analyse each frame pair in one go instead of one pass per stage
+    bool fusedAnalysis;
+
     // For Loading Video and Processing it
     VideoProcessor vp;
 
@@ -88,6 +144,11 @@ private:
 
     void clear();
 
+    // Videos are encoded with the given codec, or written as Y4M or raw BGR frames
+    enum OutputFormat {VIDEO_OUTPUT, Y4M_OUTPUT, RAW_OUTPUT};
+    OutputFormat outputFormat;
+    FrameSink* openSink(QString path, Size size, int fourCC, double fps);
+
 };
 
 #endif // COREAPPLICATION_H
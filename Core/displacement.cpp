@@ -1,6 +1,6 @@
 #include "displacement.h"
 
-Displacement::Displacement(const Point2f& from, const Point2f& to):from(from),to(to)
+Displacement::Displacement(const Point2f& from, const Point2f& to, float error):from(from),to(to),error(error)
 {
 
 }
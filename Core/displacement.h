@@ -8,15 +8,17 @@ using namespace cv;
 class Displacement
 {
 public:
-    Displacement(const Point2f& from, const Point2f& to);
+    Displacement(const Point2f& from, const Point2f& to, float error = 0);
 
     const Point2f getDisplacement() const;
     const Point2f& getFrom() const;
     const Point2f& getTo() const;
+    float getError() const {return error;}
 
 private:
     Point2f from;
     Point2f to;
+    float error; // Tracking error reported by the optical flow
 };
 
 #endif // DISPLACEMENT_H
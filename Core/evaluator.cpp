@@ -81,7 +81,7 @@ string boolToStr(bool b) {
     return (b ? "true" : "false");
 }
 
-void Evaluator::drawOriginalPath(const QList<Mat>& transforms, bool showX, bool showY) {
+void Evaluator::drawOriginalPath(const TransformData& transforms, bool showX, bool showY) {
     qDebug() << "Evaluator::drawOriginalPath - Begin";
 
     // Convert data to Matlab Format
@@ -98,7 +98,7 @@ void Evaluator::drawOriginalPath(const QList<Mat>& transforms, bool showX, bool
     engEvalString(mEngine, stringStream.str().c_str());
 }
 
-void Evaluator::drawNewPath(const QList<Mat>& originalTransforms, QList<Mat>& updateTransforms, bool showOriginal, bool showX, bool showY) {
+void Evaluator::drawNewPath(const TransformData& originalTransforms, const TransformData& updateTransforms, bool showOriginal, bool showX, bool showY) {
     qDebug() << "Evaluator::drawNewPath - Begin";
 
     // Convert data to Matlab Format
@@ -116,7 +116,7 @@ void Evaluator::drawNewPath(const QList<Mat>& originalTransforms, QList<Mat>& up
 
 }
 
-void Evaluator::exportMatrices(QList<Mat> matrices, QString filePath, QString name) {
+void Evaluator::exportMatrices(const TransformData& matrices, QString filePath, QString name) {
     // Move matrices into a cell array
     mxArray *cellArray = convertToMatlab(matrices);
 
@@ -133,21 +133,21 @@ void Evaluator::exportMatrices(QList<Mat> matrices, QString filePath, QString na
     matClose(matFile);
 }
 
-mxArray* Evaluator::convertToMatlab(const QList<Mat>& transforms){
+mxArray* Evaluator::convertToMatlab(const TransformData& transforms){
     qDebug() << "Evaluator::convertToMatlab - Begin";
+    assert(transforms.empty() || transforms.type() == DataType<float>::type);
     // Convert N 2x3 transforms into a cell of 2x3 arrays
-    mxArray *cellArray = mxCreateCellMatrix(transforms.size(), 1);
-    for (int i = 0; i < transforms.size(); i++) {
-        Mat m = transforms[i];
-        m.convertTo(m, CV_32F);
-        int rows = m.rows;
-        int cols = m.cols;
+    const int rows = 2, cols = 3;
+    int count = transforms.rows / rows;
+    mxArray *cellArray = mxCreateCellMatrix(count, 1);
+    for (int i = 0; i < count; i++) {
         //Mat data is float, and mxArray uses double, so we need to convert.
         mxArray *T=mxCreateDoubleMatrix(rows, cols, mxREAL);
         double *buffer = (double*)mxGetPr(T);
         for (int r = 0; r < rows; r++) {
+            const float* row = transforms.ptr<float>(i*rows + r);
             for (int c = 0; c < cols; c++) {
-                buffer[c*rows+r] = (double)m.at<float>(r,c);
+                buffer[c*rows+r] = (double)row[c];
             }
         }
         mxSetCell(cellArray, i, T);
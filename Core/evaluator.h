@@ -7,7 +7,8 @@
 #include "tools.h"
 
 typedef QMap<int, Point2f> DataSet;
-typedef QList<Mat> TransformData;
+// 2x3 transforms stacked in a 2N x 3 float Mat, as by Video::getAffineTransforms
+typedef Mat TransformData;
 
 /*
  *  This class exports Mat data to the Matlab Engine
@@ -23,12 +24,12 @@ public:
     void drawData(const DataSet& data);
     void drawData(const DataSet& origData, const DataSet& newData);
 
-    void drawOriginalPath(const QList<Mat>& transforms, bool showX, bool showY);
-    void drawNewPath(const QList<Mat>& originalTransforms, QList<Mat>& updateTransforms, bool showOriginal, bool showX, bool showY);
+    void drawOriginalPath(const TransformData& transforms, bool showX, bool showY);
+    void drawNewPath(const TransformData& originalTransforms, const TransformData& updateTransforms, bool showOriginal, bool showX, bool showY);
 
-    mxArray* convertToMatlab(const QList<Mat>& transforms);
+    mxArray* convertToMatlab(const TransformData& transforms);
 
-    void exportMatrices(QList<Mat> matrices, QString filePath, QString name);
+    void exportMatrices(const TransformData& matrices, QString filePath, QString name);
 
 private:
     Engine* mEngine;
@@ -0,0 +1,182 @@
+#include "exportplanner.h"
+#include "videoprocessor.h"
+#include "frame.h"
+#include "tools.h"
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QDebug>
+
+namespace {
+    // Hands back the outputs of frames rendered in any order in the order they were submitted
+    class ReorderBuffer
+    {
+    public:
+        ReorderBuffer(): next(0) {}
+
+        void add(int index, const QVector<Mat>& images) {
+            QMutexLocker locker(&mutex);
+            pending.insert(index, images);
+            if (index == next) {
+                arrived.wakeAll();
+            }
+        }
+
+        // Blocks until the next outputs in order have been added
+        QVector<Mat> takeNext() {
+            QMutexLocker locker(&mutex);
+            while (!pending.contains(next)) {
+                arrived.wait(&mutex);
+            }
+            return pending.take(next++);
+        }
+
+    private:
+        QMutex mutex;
+        QWaitCondition arrived;
+        QMap<int, QVector<Mat> > pending;
+        int next;
+    };
+
+    // Renders the requested outputs of one frame
+    class RenderTask : public QRunnable
+    {
+    public:
+        RenderTask(const ExportPlanner* planner, const Video* video, int frameNumber, int index, ReorderBuffer& rendered):
+            planner(planner), video(video), frameNumber(frameNumber), index(index), rendered(rendered) {}
+
+        void run() {
+            rendered.add(index, planner->renderFrame(video, frameNumber));
+        }
+
+    private:
+        const ExportPlanner* planner;
+        const Video* video;
+        int frameNumber;
+        int index;
+        ReorderBuffer& rendered;
+    };
+}
+
+ExportPlanner::ExportPlanner(QObject *parent) :
+    QObject(parent), interpolation(INTER_CUBIC)
+{
+}
+
+void ExportPlanner::addVideo(Output output, FrameSink* sink)
+{
+    videos[output].append(sink);
+}
+
+void ExportPlanner::addFrame(Output output, int frameNumber, const QString& path)
+{
+    frames[frameNumber].append(qMakePair(output, path));
+}
+
+bool ExportPlanner::isRequested(Output output, int frameNumber) const
+{
+    if (!videos[output].isEmpty()) {
+        return true;
+    }
+    const QList<QPair<Output, QString> > files = frames.value(frameNumber);
+    for (int i = 0; i < files.size(); i++) {
+        if (files[i].first == output) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ExportPlanner::run(Video* video)
+{
+    qDebug() << "ExportPlanner::run - Started";
+    // Videos need every frame, single images only their own
+    QList<int> frameNumbers = frames.keys();
+    for (int o = 0; o < OUTPUT_COUNT; o++) {
+        if (!videos[o].isEmpty()) {
+            frameNumbers.clear();
+            for (int f = 0; f < video->getFrameCount(); f++) {
+                frameNumbers.append(f);
+            }
+            break;
+        }
+    }
+
+    // Declared first so it outlives the pool, whose tasks may still be returning from add
+    ReorderBuffer rendered;
+    QThreadPool pool;
+    // Only so many frames are rendering or waiting for an earlier frame at any time
+    int window = 2 * pool.maxThreadCount();
+    int total = frameNumbers.size();
+    int submitted = 0, written = 0;
+    while (written < total) {
+        if (submitted < total && submitted - written < window) {
+            pool.start(new RenderTask(this, video, frameNumbers[submitted], submitted, rendered));
+            submitted++;
+            continue;
+        }
+        QVector<Mat> images = rendered.takeNext();
+        for (int o = 0; o < OUTPUT_COUNT; o++) {
+            for (int i = 0; i < videos[o].size(); i++) {
+                videos[o][i]->write(images[o]);
+            }
+        }
+        const QList<QPair<Output, QString> > files = frames.value(frameNumbers[written]);
+        for (int i = 0; i < files.size(); i++) {
+            cv::imwrite(files[i].second.toStdString(), images[files[i].first]);
+        }
+        written++;
+        emit processProgressChanged(float(written)/total);
+    }
+    pool.waitForDone();
+    qDebug() << "ExportPlanner::run - Finished";
+}
+
+QVector<Mat> ExportPlanner::renderFrame(const Video* video, int frameNumber) const
+{
+    QVector<Mat> images(OUTPUT_COUNT);
+    for (int o = 0; o < OUTPUT_COUNT; o++) {
+        if (isRequested(Output(o), frameNumber)) {
+            images[o] = render(Output(o), video, frameNumber, interpolation);
+        }
+    }
+    return images;
+}
+
+Mat ExportPlanner::render(Output output, const Video* video, int frameNumber, int interpolation)
+{
+    const Frame* frame = video->getFrameAt(frameNumber);
+    const Mat& image = frame->getOriginalData();
+    const Rect& cropBox = video->getCropBox();
+    switch (output) {
+    case STABILISED:
+        if (frameNumber == 0) {
+            return image(cropBox);
+        }
+        //Move cropWindow from current position to next position using frame's update transform
+        return VideoProcessor::cropImage(image, frame->getUpdateTransform(), cropBox, interpolation);
+    case CROPPED:
+        return image(cropBox);
+    case OVERLAY: {
+        // Drawn on, so it needs its own copy
+        Mat overlay = image.clone();
+        if (frameNumber == 0) {
+            cv::rectangle(overlay, cropBox, Scalar(0,255,0), 3);
+        } else {
+            RotatedRect newCrop = Tools::transformRectangle(Matx23f(frame->getUpdateTransform()), cropBox);
+            Point2f verts[4];
+            newCrop.points(verts);
+            for (int i = 0; i < 4; i++) {
+                line(overlay, verts[i], verts[(i+1)%4], Scalar(0,255,0),3);
+            }
+        }
+        return overlay;
+    }
+    default:
+        return image;
+    }
+}
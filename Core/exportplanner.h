@@ -0,0 +1,64 @@
+#ifndef EXPORTPLANNER_H
+#define EXPORTPLANNER_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+#include "video.h"
+#include "framesink.h"
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+using namespace cv;
+
+/*
+ *
+ *  Produces every requested output of a video in a single pass.
+ *  Each frame is read once and all of its outputs are rendered
+ *  together on a pool of worker threads, then written in frame
+ *  order to the sinks and image files that asked for them.
+ *
+ */
+class ExportPlanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    // What can be rendered from a frame
+    enum Output {STABILISED, CROPPED, OVERLAY, ORIGINAL};
+    static const int OUTPUT_COUNT = 4;
+
+    explicit ExportPlanner(QObject *parent = 0);
+
+    // Writes every frame of the output to the sink, which must outlive run
+    void addVideo(Output output, FrameSink* sink);
+
+    // Saves a single frame of the output as an image file
+    void addFrame(Output output, int frameNumber, const QString& path);
+
+    // Interpolation used for the stabilised frames, bicubic by default
+    void setInterpolation(int interpolation) {this->interpolation = interpolation;}
+
+    // Pre: the update transforms of the video are set if STABILISED or OVERLAY is requested
+    void run(Video* video);
+
+    // Renders all requested outputs of one frame, indexed by Output. Safe to
+    // call from several threads at once
+    QVector<Mat> renderFrame(const Video* video, int frameNumber) const;
+
+    static Mat render(Output output, const Video* video, int frameNumber, int interpolation = INTER_CUBIC);
+
+signals:
+    void processProgressChanged(float);
+
+private:
+    QList<FrameSink*> videos[OUTPUT_COUNT];
+    QMap<int, QList<QPair<Output, QString> > > frames;
+    int interpolation;
+
+    bool isRequested(Output output, int frameNumber) const;
+};
+
+#endif // EXPORTPLANNER_H
@@ -23,8 +23,11 @@ void Frame::reset()
     dy = Mat::zeros(image.rows, image.cols, DataType<float>::type);
     displacementMask = Mat::zeros(image.rows, image.cols, DataType<int>::type);
     outlierMask = Mat::zeros(image.rows, image.cols, DataType<int>::type);
-    affine = Mat::zeros(2,3,DataType<float>::type);
-    update = Mat::zeros(2,3,DataType<float>::type);
+    // Cleared in place, they may be stored in the video
+    affine.create(2,3,DataType<float>::type);
+    affine.setTo(0);
+    update.create(2,3,DataType<float>::type);
+    update.setTo(0);
 }
 
 
@@ -137,16 +140,52 @@ void Frame::getInliers(vector<Point2f>& srcPoints, vector<Point2f>& destPoints)
     assert(((uint) cv::countNonZero(outlierMask)) + destPoints.size() == displacements.size());
 }
 
+void Frame::getInliers(vector<Point2f>& srcPoints, vector<Point2f>& destPoints, vector<float>& errors) const
+{
+    QMutexLocker locker(&mutex);
+    assert(srcPoints.size() == 0 && destPoints.size() == 0 && errors.size() == 0);
+    for (uint i = 0; i < displacements.size(); i++) {
+        const Displacement& disp = displacements.at(i);
+        const Point2f src = disp.getFrom();
+        if (outlierMask.at<int>(src) != 1) {
+            srcPoints.push_back(src);
+            destPoints.push_back(disp.getTo());
+            errors.push_back(disp.getError());
+        }
+    }
+    assert(srcPoints.size() == destPoints.size());
+}
+
+// Written in place, so the transforms stay in the video's storage
 void Frame::setAffineTransform(const Mat& affine)
 {
     QMutexLocker locker(&mutex);
-    affine.copyTo(this->affine);
+    affine.convertTo(this->affine, DataType<float>::type);
 }
 
 void Frame::setUpdateTransform(const Mat& update)
 {
     QMutexLocker locker(&mutex);
-    update.copyTo(this->update);
+    update.convertTo(this->update, DataType<float>::type);
+}
+
+namespace {
+    void copyTransform(const Mat& transform, Mat& storage) {
+        if (transform.empty()) {
+            storage.setTo(0);
+        } else {
+            transform.convertTo(storage, DataType<float>::type);
+        }
+    }
+}
+
+void Frame::bindTransforms(Mat affine, Mat update)
+{
+    QMutexLocker locker(&mutex);
+    copyTransform(this->affine, affine);
+    copyTransform(this->update, update);
+    this->affine = affine;
+    this->update = update;
 }
 
 
@@ -182,3 +221,13 @@ vector<Point2f> Frame::getTo() const
     }
     return points;
 }
+
+vector<float> Frame::getErrors() const
+{
+    vector<float> errors;
+    const vector<Displacement> displacements = getDisplacements();
+    for (uint i = 0; i < displacements.size(); i++) {
+        errors.push_back(displacements.at(i).getError());
+    }
+    return errors;
+}
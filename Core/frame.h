@@ -20,6 +20,10 @@ public:
 
     const Mat& getOriginalData() const {QMutexLocker locker(&mutex); return image;}
 
+    // Shares the image without copying it. Lazily rendered frames are filled in
+    // and released with this
+    void setImage(const Mat& image) {QMutexLocker locker(&mutex); this->image = image;}
+
     void setFeatures (const vector<Point2f>& features);
     const vector<Point2f>& getFeatures() const {QMutexLocker locker(&mutex); return features;}
 
@@ -32,11 +36,13 @@ public:
 
     vector<Point2f> getFrom() const;
     vector<Point2f> getTo() const;
+    vector<float> getErrors() const;
 
     vector<Point2f> getOutliers() const;
     vector<Point2f> getInliers() const;
 
     void getInliers(vector<Point2f>& srcPoints, vector<Point2f>& destPoints) const;
+    void getInliers(vector<Point2f>& srcPoints, vector<Point2f>& destPoints, vector<float>& errors) const;
     void getInliersAndOutliers(vector<Point2f>& srcPoints, vector<Point2f>& destPoints) const;
 
     void setAffineTransform(const Mat& affine);
@@ -45,6 +51,9 @@ public:
     void setUpdateTransform(const Mat& update);
     const Mat& getUpdateTransform() const {QMutexLocker locker(&mutex); return update;}
 
+    // Moves the transforms into 2x3 float storage owned by the video
+    void bindTransforms(Mat affine, Mat update);
+
     void setFeature(Point2f* feature);
     Point2f* getFeature() {return feature;}
 
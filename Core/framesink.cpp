@@ -0,0 +1,120 @@
+#include "framesink.h"
+#include "frame.h"
+#include <opencv2/imgproc/imgproc.hpp>
+#include <QDebug>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+
+FrameSink::~FrameSink()
+{
+}
+
+VideoWriterSink::VideoWriterSink(const QString& path, int fourCC, double fps, Size size)
+{
+    writer.open(path.toStdString(), fourCC, fps, size);
+}
+
+void VideoWriterSink::write(const Mat& image)
+{
+    writer << image;
+}
+
+void VideoSink::write(const Mat& image)
+{
+    video->appendFrame(new Frame(image, video));
+}
+
+RawSink::RawSink(const QString& path)
+{
+    isStdout = path == "-";
+    failed = false;
+    file = isStdout ? stdout : fopen(path.toLocal8Bit().constData(), "wb");
+    if (file == 0) {
+        qDebug() << "RawSink - Could not open" << path;
+    }
+}
+
+RawSink::~RawSink()
+{
+    if (file == 0) {
+        return;
+    }
+    if (isStdout) {
+        fflush(file);
+    } else {
+        fclose(file);
+    }
+}
+
+void RawSink::write(const Mat& image)
+{
+    if (!isOpened()) {
+        return;
+    }
+    writePlane(image);
+}
+
+void RawSink::checkWrite(bool written)
+{
+    if (!written && !failed) {
+        failed = true;
+        qWarning() << "RawSink - Writing frames failed:" << strerror(errno);
+    }
+}
+
+// Crops are often views into a larger frame, so rows are written one by one
+void RawSink::writePlane(const Mat& plane)
+{
+    size_t rowBytes = plane.cols * plane.elemSize();
+    for (int y = 0; y < plane.rows && !failed; y++) {
+        checkWrite(fwrite(plane.ptr(y), 1, rowBytes, file) == rowBytes);
+    }
+}
+
+namespace {
+    int gcd(int a, int b) {
+        return b == 0 ? a : gcd(b, a % b);
+    }
+
+    // NTSC style rates are N*1000/1001, anything else is kept to a thousandth of a frame
+    void toFrameRateRatio(double fps, int& numerator, int& denominator) {
+        int ntsc = qRound(fps * 1001 / 1000);
+        if (fabs(fps - ntsc * 1000.0 / 1001) < 0.001 && fabs(fps - ntsc) > 0.001) {
+            numerator = ntsc * 1000;
+            denominator = 1001;
+            return;
+        }
+        numerator = qRound(fps * 1000);
+        denominator = 1000;
+        int divisor = gcd(numerator, denominator);
+        numerator /= divisor;
+        denominator /= divisor;
+    }
+}
+
+Y4MSink::Y4MSink(const QString& path, double fps, Size size) :
+    RawSink(path)
+{
+    if (file != 0) {
+        int numerator, denominator;
+        toFrameRateRatio(fps, numerator, denominator);
+        checkWrite(fprintf(file, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C444 XCOLORRANGE=FULL\n",
+                           size.width, size.height, numerator, denominator) >= 0);
+    }
+}
+
+void Y4MSink::write(const Mat& image)
+{
+    if (!isOpened()) {
+        return;
+    }
+    Mat ycrcb;
+    cvtColor(image, ycrcb, CV_BGR2YCrCb);
+    vector<Mat> planes;
+    split(ycrcb, planes);
+    checkWrite(fputs("FRAME\n", file) != EOF);
+    writePlane(planes[0]);
+    writePlane(planes[2]); // Cb
+    writePlane(planes[1]); // Cr
+}
@@ -0,0 +1,90 @@
+#ifndef FRAMESINK_H
+#define FRAMESINK_H
+
+#include <QString>
+#include <stdio.h>
+#include "video.h"
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+using namespace cv;
+
+/*
+ *
+ *  Destination of rendered frames. Frames are written in order
+ *  and are not kept once written, so a video can be rendered
+ *  without holding all of its frames in memory.
+ *
+ */
+class FrameSink
+{
+public:
+    virtual ~FrameSink();
+
+    // False if the sink could not be opened, or once writing to it has failed
+    virtual bool isOpened() const = 0;
+    virtual void write(const Mat& image) = 0;
+};
+
+// Encodes the frames with a VideoWriter
+class VideoWriterSink : public FrameSink
+{
+public:
+    VideoWriterSink(const QString& path, int fourCC, double fps, Size size);
+
+    bool isOpened() const {return writer.isOpened();}
+    void write(const Mat& image);
+
+private:
+    VideoWriter writer;
+};
+
+// Appends the frames to a video, for frontends that show the whole result.
+// Must be written to from the thread the video belongs to
+class VideoSink : public FrameSink
+{
+public:
+    explicit VideoSink(Video* video) : video(video) {}
+
+    bool isOpened() const {return video != 0;}
+    void write(const Mat& image);
+
+private:
+    Video* video;
+};
+
+// Writes the raw BGR bytes of each frame, without any header, to a file.
+// A path of "-" writes to stdout so the frames can be piped to an encoder
+class RawSink : public FrameSink
+{
+public:
+    explicit RawSink(const QString& path);
+    ~RawSink();
+
+    bool isOpened() const {return file != 0 && !failed;}
+    void write(const Mat& image);
+
+protected:
+    FILE* file;
+    bool isStdout;
+
+    // Set when a write fails, for instance when the reader of stdout exits.
+    // Nothing more is written after that
+    volatile bool failed;
+    void checkWrite(bool written);
+
+    void writePlane(const Mat& plane);
+};
+
+// YUV4MPEG2 stream with full resolution, full range chroma (C444),
+// which ffmpeg and most encoders read directly
+class Y4MSink : public RawSink
+{
+public:
+    // The frame rate is written as a ratio, so 29.97 fps is 30000:1001
+    Y4MSink(const QString& path, double fps, Size size);
+
+    void write(const Mat& image);
+};
+
+#endif // FRAMESINK_H
@@ -0,0 +1,174 @@
+#include "hierarchicalransacrejector.h"
+#include <QDebug>
+#include <math.h>
+
+HierarchicalRANSACRejector::HierarchicalRANSACRejector(QObject *parent) :
+    OutlierRejector(parent)
+{
+    minCellSize = 25;
+    minCellPoints = 6;
+    tolerance = 2;
+    fitRatio = 0.75;
+    confidence = 0.99;
+    maxIterations = 30;
+}
+
+HierarchicalRANSACRejector::HierarchicalRANSACRejector(int minCellSize, int minCellPoints, double tolerance, double fitRatio, QObject *parent):
+    OutlierRejector(parent), minCellSize(minCellSize), minCellPoints(minCellPoints), tolerance(tolerance), fitRatio(fitRatio)
+{
+    confidence = 0.99;
+    maxIterations = 30;
+}
+
+void HierarchicalRANSACRejector::process(Size frameSize, InputArray from, InputArray to, InputArray errors, OutputArray mask) const {
+    int npoints = std::max(from.getMat().checkVector(2), 0);
+
+    mask.create(1, npoints, CV_8U);
+    if (npoints == 0) {
+        return;
+    }
+    uchar* mask_ = mask.getMat().ptr<uchar>();
+    const Point2f* from_ = from.getMat().ptr<Point2f>();
+    const Point2f* to_ = to.getMat().ptr<Point2f>();
+    Mat errorsMat = errors.getMat();
+    bool ordered = !errorsMat.empty();
+
+    // The root cell covers the whole frame and has no parent to fall back on
+    Cell root(npoints);
+    for (int i = 0; i < npoints; i++) {
+        root[i] = i;
+    }
+    // Sorted once here, quadrants keep the order when the root is split
+    if (ordered) {
+        sortByError(root, errorsMat.ptr<float>());
+    }
+    refine(from_, to_, root, Rect(0, 0, frameSize.width, frameSize.height), 0, ordered, mask_);
+}
+
+void HierarchicalRANSACRejector::refine(const Point2f* from, const Point2f* to, const Cell& cell, const Rect& region, const Point2f* parentModel, bool ordered, uchar* mask) const {
+    if (cell.empty()) {
+        return;
+    }
+    // Too sparse for RANSAC to mean anything
+    if ((int) cell.size() < minCellPoints && parentModel != 0) {
+        applyModel(from, to, cell, *parentModel, mask);
+        return;
+    }
+
+    Point2f model;
+    ransac(from, to, cell, ordered, model);
+    model = fitInliers(from, to, cell, model);
+    int ninliers = countInliers(from, to, cell, model);
+
+    // Stop where the translation already fits, or where splitting cannot help
+    bool fits = ninliers >= fitRatio * cell.size();
+    bool dense = (int) cell.size() >= 4 * minCellPoints;
+    bool splittable = region.width >= 2 * minCellSize && region.height >= 2 * minCellSize;
+    if (fits || !dense || !splittable || motionVariance(from, to, cell) <= tolerance * tolerance) {
+        applyModel(from, to, cell, model, mask);
+        return;
+    }
+
+    // Split into quadrants, each inheriting this cell's model
+    int halfWidth = region.width / 2;
+    int halfHeight = region.height / 2;
+    Rect quadrants[4] = {
+        Rect(region.x, region.y, halfWidth, halfHeight),
+        Rect(region.x + halfWidth, region.y, region.width - halfWidth, halfHeight),
+        Rect(region.x, region.y + halfHeight, halfWidth, region.height - halfHeight),
+        Rect(region.x + halfWidth, region.y + halfHeight, region.width - halfWidth, region.height - halfHeight)
+    };
+    Cell children[4];
+    for (size_t i = 0; i < cell.size(); i++) {
+        const Point2f& p = from[cell[i]];
+        int q = (p.x >= region.x + halfWidth ? 1 : 0) + (p.y >= region.y + halfHeight ? 2 : 0);
+        children[q].push_back(cell[i]);
+    }
+    for (int q = 0; q < 4; q++) {
+        refine(from, to, children[q], quadrants[q], &model, ordered, mask);
+    }
+}
+
+/*
+ *  One point RANSAC for a translation. The number of hypotheses is
+ *  bounded by the number of points in the cell and shrinks as the
+ *  best inlier ratio improves. If the cell is ordered by tracking
+ *  error the hypotheses are taken in that order (PROSAC with a one
+ *  point sample).
+ */
+int HierarchicalRANSACRejector::ransac(const Point2f* from, const Point2f* to, const Cell& cell, bool ordered, Point2f& model) const {
+    int npoints = cell.size();
+    bool exhaustive = ordered || npoints <= maxIterations;
+    int niters = std::min(npoints, maxIterations);
+    int ninliersMax = 0;
+    model = Point2f(0, 0);
+    for (int iter = 0; iter < niters; iter++) {
+        int idx = exhaustive ? cell[iter] : cell[static_cast<unsigned>(rand()) % npoints];
+        Point2f hypothesis = to[idx] - from[idx];
+        int ninliers = countInliers(from, to, cell, hypothesis);
+        if (ninliers > ninliersMax) {
+            ninliersMax = ninliers;
+            model = hypothesis;
+            double inlierRatio = double(ninliersMax) / npoints;
+            if (inlierRatio >= 1) {
+                break;
+            }
+            int needed = cvCeil(log(1 - confidence) / log(1 - inlierRatio));
+            niters = std::min(niters, std::max(needed, 1));
+        }
+    }
+    return ninliersMax;
+}
+
+int HierarchicalRANSACRejector::countInliers(const Point2f* from, const Point2f* to, const Cell& cell, const Point2f& model) const {
+    double tolerance2 = tolerance * tolerance;
+    int ninliers = 0;
+    for (size_t i = 0; i < cell.size(); i++) {
+        Point2f residual = from[cell[i]] + model - to[cell[i]];
+        if (residual.dot(residual) < tolerance2) {
+            ninliers++;
+        }
+    }
+    return ninliers;
+}
+
+// Mean displacement of the inliers of model
+Point2f HierarchicalRANSACRejector::fitInliers(const Point2f* from, const Point2f* to, const Cell& cell, const Point2f& model) const {
+    double tolerance2 = tolerance * tolerance;
+    Point2f sum(0, 0);
+    int ninliers = 0;
+    for (size_t i = 0; i < cell.size(); i++) {
+        Point2f disp = to[cell[i]] - from[cell[i]];
+        Point2f residual = model - disp;
+        if (residual.dot(residual) < tolerance2) {
+            sum += disp;
+            ninliers++;
+        }
+    }
+    if (ninliers == 0) {
+        return model;
+    }
+    return sum * (1.0f / ninliers);
+}
+
+double HierarchicalRANSACRejector::motionVariance(const Point2f* from, const Point2f* to, const Cell& cell) const {
+    Point2f mean(0, 0);
+    for (size_t i = 0; i < cell.size(); i++) {
+        mean += to[cell[i]] - from[cell[i]];
+    }
+    mean *= 1.0f / cell.size();
+    double variance = 0;
+    for (size_t i = 0; i < cell.size(); i++) {
+        Point2f diff = to[cell[i]] - from[cell[i]] - mean;
+        variance += diff.dot(diff);
+    }
+    return variance / cell.size();
+}
+
+void HierarchicalRANSACRejector::applyModel(const Point2f* from, const Point2f* to, const Cell& cell, const Point2f& model, uchar* mask) const {
+    double tolerance2 = tolerance * tolerance;
+    for (size_t i = 0; i < cell.size(); i++) {
+        Point2f residual = from[cell[i]] + model - to[cell[i]];
+        mask[cell[i]] = residual.dot(residual) < tolerance2 ? 1 : 0;
+    }
+}
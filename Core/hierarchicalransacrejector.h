@@ -0,0 +1,43 @@
+#ifndef HIERARCHICALRANSACREJECTOR_H
+#define HIERARCHICALRANSACREJECTOR_H
+
+#include <QObject>
+#include "outlierrejector.h"
+#include "video.h"
+
+/*
+ *
+ *  Quadtree variant of the LocalRANSACRejector.
+ *  Starts with the whole frame as one cell and only splits a cell
+ *  into quadrants while it is dense and a single translation does
+ *  not explain its motion. Cells with too few points to run RANSAC
+ *  on inherit the translation of their parent.
+ *
+ */
+class HierarchicalRANSACRejector : public OutlierRejector
+{
+    Q_OBJECT
+public:
+    explicit HierarchicalRANSACRejector(QObject *parent = 0);
+    HierarchicalRANSACRejector(int minCellSize, int minCellPoints, double tolerance, double fitRatio, QObject *parent = 0);
+    void process(Size frameSize, InputArray from, InputArray to, InputArray errors, OutputArray mask) const;
+
+private:
+    // Settings
+    int minCellSize;     // Cells are never split below this side length
+    int minCellPoints;   // Cells with fewer points use their parent's model
+    double tolerance;    // Inlier distance in pixels
+    double fitRatio;     // Inlier ratio at which a cell stops splitting
+    double confidence;   // Used to terminate RANSAC early
+    int maxIterations;
+
+    void refine(const Point2f* from, const Point2f* to, const Cell& cell, const Rect& region, const Point2f* parentModel, bool ordered, uchar* mask) const;
+    int ransac(const Point2f* from, const Point2f* to, const Cell& cell, bool ordered, Point2f& model) const;
+    int countInliers(const Point2f* from, const Point2f* to, const Cell& cell, const Point2f& model) const;
+    Point2f fitInliers(const Point2f* from, const Point2f* to, const Cell& cell, const Point2f& model) const;
+    double motionVariance(const Point2f* from, const Point2f* to, const Cell& cell) const;
+    void applyModel(const Point2f* from, const Point2f* to, const Cell& cell, const Point2f& model, uchar* mask) const;
+
+};
+
+#endif // HIERARCHICALRANSACREJECTOR_H
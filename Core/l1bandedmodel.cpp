@@ -0,0 +1,320 @@
+#include "l1bandedmodel.h"
+#include "l1model.h"
+#include "frame.h"
+#include <QDebug>
+#include <limits>
+#include <math.h>
+
+namespace {
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    double softThreshold(double x, double k) {
+        if (x > k) {
+            return x - k;
+        } else if (x < -k) {
+            return x + k;
+        }
+        return 0;
+    }
+
+    double clamp(double x, double lb, double ub) {
+        return std::min(std::max(x, lb), ub);
+    }
+}
+
+L1BandedModel::L1BandedModel(int dof)
+{
+    tolerance = 1e-3;
+    rho = 1;
+    maxIterations = 5000;
+    iterations = 0;
+    maxT = 0;
+    firstFrame = 1;
+    anchor = Vec6d(1, 0, 0, 1, 0, 0);
+    setDOF(dof);
+}
+
+void L1BandedModel::setDOF(int dof)
+{
+    assert(dof == 2 || dof == 4 || dof == 6);
+    this->dof = dof;
+}
+
+void L1BandedModel::setAnchor(const Mat& anchor)
+{
+    for (char c = 'a'; c <= 'f'; c++) {
+        this->anchor[c-'a'] = getElem(anchor, c);
+    }
+}
+
+void L1BandedModel::prepare(Video* video)
+{
+    prepare(video, 1, video->getFrameCount()-1);
+}
+
+void L1BandedModel::prepare(Video* video, int firstFrame, int numFrames)
+{
+    assert(firstFrame >= 1 && firstFrame+numFrames <= video->getFrameCount());
+    this->firstFrame = firstFrame;
+    maxT = numFrames;
+
+    // Smoothness, same rows as L1Model::setSmoothnessConstraints
+    motions.assign(std::max(maxT-1, 0), Matx66d::zeros());
+    offsets.assign(std::max(maxT-1, 0), Vec6d());
+    for (int t = 0; t < maxT-1; t++) {
+        const Mat& aff = video->getFrameAt(firstFrame+t+1)->getAffineTransform(); // F(t+1)
+        double a = getElem(aff,'a'), b = getElem(aff,'b'), c = getElem(aff,'c'), d = getElem(aff,'d');
+        Matx66d& m = motions[t];
+        m(0,0) = a; m(0,2) = b;
+        m(1,1) = a; m(1,3) = b;
+        m(2,0) = c; m(2,2) = d;
+        m(3,1) = c; m(3,3) = d;
+        m(4,4) = a; m(4,5) = b;
+        m(5,4) = c; m(5,5) = d;
+        offsets[t] = Vec6d(0, 0, 0, 0, getElem(aff,'e'), getElem(aff,'f'));
+    }
+
+    rows.clear();
+    rowLb.clear();
+    rowUb.clear();
+    rowOnLastFrame.clear();
+    // Inclusion
+    Rect cropBox = video->getCropBox();
+    for (int x = cropBox.x; x <= cropBox.x+cropBox.width; x+=cropBox.width) {
+        for (int y = cropBox.y; y <= cropBox.y+cropBox.height; y+=cropBox.height) {
+            addRow(Vec6d(x, y, 0, 0, 1, 0), 0, video->getWidth());
+            addRow(Vec6d(0, 0, x, y, 0, 1), 0, video->getHeight());
+        }
+    }
+    // Proximity
+    addRow(Vec6d(1, 0, 0, 0, 0, 0), 0.9, 1.1, false);
+    addRow(Vec6d(0, 0, 0, 1, 0, 0), 0.9, 1.1, false);
+    addRow(Vec6d(0, 1, 0, 0, 0, 0), -0.1, 0.1, false);
+    addRow(Vec6d(0, 0, 1, 0, 0, 0), -0.1, 0.1, false);
+    addRow(Vec6d(0, 1, 1, 0, 0, 0), -0.05, 0.05, false);
+    addRow(Vec6d(1, 0, 0, -1, 0, 0), -0.1, 0.1, false);
+    if (dof == 4) {
+        addRow(Vec6d(1, 0, 0, -1, 0, 0), 0, 0);
+        addRow(Vec6d(0, 1, 1, 0, 0, 0), 0, 0);
+    } else if (dof == 2) {
+        addRow(Vec6d(1, 0, 0, 0, 0, 0), 1, 1);
+        addRow(Vec6d(0, 1, 0, 0, 0, 0), 0, 0);
+        addRow(Vec6d(0, 0, 1, 0, 0, 0), 0, 0);
+        addRow(Vec6d(0, 0, 0, 1, 0, 0), 1, 1);
+    }
+
+    p.assign(maxT, anchor);
+    factorise();
+}
+
+// Rows are normalised so one penalty suits pixel and linear constraints alike
+void L1BandedModel::addRow(const Vec6d& row, double lb, double ub, bool onLastFrame)
+{
+    double norm = sqrt(row.dot(row));
+    rows.push_back(row * (1 / norm));
+    rowLb.push_back(lb / norm);
+    rowUb.push_back(ub / norm);
+    rowOnLastFrame.push_back(onLastFrame);
+}
+
+/*
+ *  The least squares step of ADMM does not depend on rho. Its normal
+ *  equations are block tridiagonal with 6x6 blocks over frames 1..T-1
+ *  (frame 0 is anchored), so the block LU pivots are computed once.
+ */
+void L1BandedModel::factorise()
+{
+    Matx66d constraintsNormal = Matx66d::zeros();
+    Matx66d lastConstraintsNormal = Matx66d::zeros();
+    for (uint r = 0; r < rows.size(); r++) {
+        Matx66d outer = rows[r] * rows[r].t();
+        constraintsNormal = constraintsNormal + outer;
+        if (rowOnLastFrame[r]) {
+            lastConstraintsNormal = lastConstraintsNormal + outer;
+        }
+    }
+    pivots.assign(maxT, Matx66d::zeros());
+    for (int k = 1; k < maxT; k++) {
+        const Matx66d& m = motions[k-1];
+        Matx66d block = (k == maxT-1 ? lastConstraintsNormal : constraintsNormal) + m.t() * m;
+        if (k < maxT-1) {
+            block = block + Matx66d::eye();
+        }
+        if (k > 1) {
+            block = block - m.t() * pivots[k-1] * m;
+        }
+        pivots[k] = block.inv(DECOMP_LU);
+    }
+}
+
+void L1BandedModel::solveSystem(const vector<Vec6d>& rhs)
+{
+    vector<Vec6d> y(maxT);
+    y[1] = rhs[1];
+    for (int k = 2; k < maxT; k++) {
+        y[k] = rhs[k] + motions[k-1].t() * (pivots[k-1] * y[k-1]);
+    }
+    p[maxT-1] = pivots[maxT-1] * y[maxT-1];
+    for (int k = maxT-2; k >= 1; k--) {
+        p[k] = pivots[k] * (y[k] + motions[k] * p[k+1]);
+    }
+}
+
+bool L1BandedModel::solve()
+{
+    qDebug() << "L1BandedModel::solve - Solving";
+    iterations = 0;
+    if (maxT < 2) {
+        return true;
+    }
+    int m = rows.size();
+    int numConstraints = 6*(maxT-1) + m*(maxT-1);
+    double threshold = tolerance * sqrt(double(numConstraints));
+
+    // Split variables, starting from the anchored path
+    vector<Vec6d> z(maxT-1), u(maxT-1, Vec6d());
+    for (int t = 0; t < maxT-1; t++) {
+        z[t] = residual(t);
+    }
+    vector<double> w(maxT*m), v(maxT*m, 0);
+    for (int k = 1; k < maxT; k++) {
+        for (int r = 0; r < m; r++) {
+            w[k*m+r] = clamp(rows[r].dot(p[k]), rowLb[r], rowUb[r]);
+        }
+    }
+
+    bool converged = false;
+    vector<Vec6d> rhs(maxT);
+    while (!converged && iterations < maxIterations) {
+        iterations++;
+        // Least squares step for the path
+        for (int k = 0; k < maxT; k++) {
+            rhs[k] = Vec6d();
+        }
+        for (int t = 0; t < maxT-1; t++) {
+            Vec6d d = offsets[t] - z[t] + u[t];
+            if (t == 0) {
+                rhs[1] += motions[0].t() * (p[0] - d);
+            } else {
+                rhs[t+1] -= motions[t].t() * d;
+                rhs[t] += d;
+            }
+        }
+        for (int k = 1; k < maxT; k++) {
+            for (int r = 0; r < m; r++) {
+                if (k == maxT-1 && !rowOnLastFrame[r]) {
+                    continue;
+                }
+                rhs[k] += rows[r] * (w[k*m+r] - v[k*m+r]);
+            }
+        }
+        solveSystem(rhs);
+
+        // Soft threshold the smoothness residuals
+        double primal = 0, dual = 0;
+        for (int t = 0; t < maxT-1; t++) {
+            Vec6d res = residual(t);
+            for (int i = 0; i < 6; i++) {
+                double zi = softThreshold(res[i] + u[t][i], 1 / rho);
+                dual += (zi - z[t][i]) * (zi - z[t][i]);
+                z[t][i] = zi;
+                u[t][i] += res[i] - zi;
+                primal += (res[i] - zi) * (res[i] - zi);
+            }
+        }
+        // Clamp the constraint rows into their bounds
+        for (int k = 1; k < maxT; k++) {
+            for (int r = 0; r < m; r++) {
+                if (k == maxT-1 && !rowOnLastFrame[r]) {
+                    continue;
+                }
+                int i = k*m+r;
+                double h = rows[r].dot(p[k]);
+                double wi = clamp(h + v[i], rowLb[r], rowUb[r]);
+                dual += (wi - w[i]) * (wi - w[i]);
+                w[i] = wi;
+                v[i] += h - wi;
+                primal += (h - wi) * (h - wi);
+            }
+        }
+        primal = sqrt(primal);
+        dual = rho * sqrt(dual);
+        converged = primal < threshold && dual < threshold;
+
+        // Balance the residuals. Only the scaled duals change with rho,
+        // the factorisation does not
+        if (!converged && iterations % 50 == 0) {
+            double scale = 1;
+            if (primal > 10 * dual) {
+                scale = 2;
+            } else if (dual > 10 * primal) {
+                scale = 0.5;
+            }
+            if (scale != 1) {
+                rho *= scale;
+                for (int t = 0; t < maxT-1; t++) {
+                    u[t] *= 1 / scale;
+                }
+                for (uint i = 0; i < v.size(); i++) {
+                    v[i] /= scale;
+                }
+            }
+        }
+    }
+    enforceDOF();
+
+    if (converged) {
+        qDebug() << "L1BandedModel::solve - Converged after" << iterations << "iterations";
+    } else {
+        qDebug() << "L1BandedModel::solve - Did not converge after" << iterations << "iterations";
+    }
+    return converged;
+}
+
+// ADMM only meets the equality rows to within the tolerance, make them exact
+void L1BandedModel::enforceDOF()
+{
+    for (int k = 1; k < maxT; k++) {
+        Vec6d& q = p[k];
+        if (dof == 2) {
+            q[0] = 1;
+            q[1] = 0;
+            q[2] = 0;
+            q[3] = 1;
+        } else if (dof == 4) {
+            double scale = (q[0] + q[3]) / 2;
+            double rotation = (q[1] - q[2]) / 2;
+            q[0] = scale;
+            q[3] = scale;
+            q[1] = rotation;
+            q[2] = -rotation;
+        }
+    }
+}
+
+Vec6d L1BandedModel::residual(int t) const
+{
+    return motions[t] * p[t+1] - p[t] + offsets[t];
+}
+
+double L1BandedModel::getVariableSolution(int t, char ch)
+{
+    return p[t-firstFrame][ch-'a'];
+}
+
+double L1BandedModel::getObjectiveValue()
+{
+    double objective = 0;
+    for (int t = 0; t < maxT-1; t++) {
+        Vec6d res = residual(t);
+        for (int i = 0; i < 6; i++) {
+            objective += fabs(res[i]);
+        }
+    }
+    return objective;
+}
+
+double L1BandedModel::getElem(const Mat& affine, char c)
+{
+    return affine.at<float>(L1Model::toRow(c),L1Model::toCol(c));
+}
@@ -0,0 +1,83 @@
+#ifndef L1BANDEDMODEL_H
+#define L1BANDEDMODEL_H
+
+#include "video.h"
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+/*
+ *
+ *  Solves the same problem as L1Model without an LP solver.
+ *  Each frame's parameters only couple to the next frame's through
+ *  the smoothness residual, and every other constraint is a bound on
+ *  a fixed linear function of one frame. ADMM splits the problem into
+ *  a block tridiagonal least squares solve (factorised once), soft
+ *  thresholding of the residuals and clamping of the constraint rows,
+ *  so each iteration is O(T).
+ *
+ */
+class L1BandedModel
+{
+public:
+    L1BandedModel(int dof = 4);
+
+    void setDOF(int dof);
+    void setAnchor(const Mat& anchor);
+
+    // Iteration stops once the primal and dual residuals are below tolerance (per row)
+    void setTolerance(double tolerance) {this->tolerance = tolerance;}
+    void setMaxIterations(int maxIterations) {this->maxIterations = maxIterations;}
+
+    void prepare(Video* video);
+    void prepare(Video* video, int firstFrame, int numFrames);
+
+    // Returns true if the residuals converged
+    bool solve();
+    double getVariableSolution(int frame, char ch);
+
+    // Sum of the smoothness residuals, comparable to the LP objective of L1Model
+    double getObjectiveValue();
+    int getIterations() const {return iterations;}
+
+private:
+    typedef Matx<double,6,6> Matx66d;
+
+    int dof;
+    double tolerance;
+    double rho;
+    int maxIterations;
+    int iterations;
+
+    int maxT;
+    int firstFrame;
+    Vec6d anchor;
+
+    // Smoothness residual t is motions[t]*p[t+1] - p[t] + offsets[t]
+    vector<Matx66d> motions;
+    vector<Vec6d> offsets;
+
+    // Constraint rows shared by every frame, rowLb[r] <= rows[r].p[t] <= rowUb[r].
+    // Like the proximity constraints of L1Model, some rows skip the last frame
+    vector<Vec6d> rows;
+    vector<double> rowLb, rowUb;
+    vector<bool> rowOnLastFrame;
+
+    // Inverses of the pivots of the block tridiagonal system
+    vector<Matx66d> pivots;
+
+    vector<Vec6d> p;
+
+    void addRow(const Vec6d& row, double lb, double ub, bool onLastFrame = true);
+    void factorise();
+    void solveSystem(const vector<Vec6d>& rhs);
+    Vec6d residual(int t) const;
+    void enforceDOF();
+
+    static double getElem(const Mat& affine, char c);
+
+};
+
+#endif // L1BANDEDMODEL_H
@@ -3,11 +3,11 @@
 #include <fstream>
 #include <coin/CoinModel.hpp>
 #include <coin/CoinPackedMatrix.hpp>
-#include <coin/CoinPackedVector.hpp>
 #include <coin/ClpDualRowSteepest.hpp>
 #include <coin/ClpPrimalColumnSteepest.hpp>
 #include <coin/ClpPresolve.hpp>
 #include <QDebug>
+#include <QElapsedTimer>
 
 
 L1Model::L1Model(int dof):si(ClpSimplex(false))
@@ -15,7 +15,20 @@ L1Model::L1Model(int dof):si(ClpSimplex(false))
     varPerFrame = 6;
     slackVarPerFrame = varPerFrame;
     isSimilarityTransform = false;
+    isTranslationTransform = false;
+    compactSimilarity = false;
     problemLoaded = false;
+    inclusionRow = 0;
+    strategy = DUAL;
+    scaling = 1;
+    presolve = true;
+    iterations = 0;
+    solveTime = 0;
+    cleanupIterations = 0;
+    cleanupTime = 0;
+    hasBasis = false;
+    firstFrame = 1;
+    anchor = (Mat_<float>(2,3) << 1, 0, 0, 0, 1, 0);
     setDOF(dof);
 }
 
@@ -34,8 +47,9 @@ void L1Model::enableDebug()
 }
 
 void L1Model::setDOF(int dof) {
-    assert(dof == 4 || dof == 6);
+    assert(dof == 2 || dof == 4 || dof == 6);
     isSimilarityTransform = dof == 4;
+    isTranslationTransform = dof == 2;
 }
 
 void L1Model::writeToFile()
@@ -45,13 +59,34 @@ void L1Model::writeToFile()
     }
 }
 
+void L1Model::setLayout(int firstFrame, int numFrames)
+{
+    this->firstFrame = firstFrame;
+    maxT = numFrames;
+    compactSimilarity = isSimilarityTransform;
+    varPerFrame = compactSimilarity ? 4 : 6;
+    slackVarPerFrame = varPerFrame;
+    cachedSolution.clear();
+}
+
+void L1Model::setAnchor(const Mat& anchor)
+{
+    anchor.copyTo(this->anchor);
+}
+
 void L1Model::prepare(Video* video)
 {
-    vector<Mat> frameMotions = video->getAffineTransforms();
+    prepare(video, 1, video->getFrameCount()-1);
+}
+
+void L1Model::prepare(Video* video, int firstFrame, int numFrames)
+{
+    assert(firstFrame >= 1 && firstFrame+numFrames <= video->getFrameCount());
+    Mat frameMotions = video->getAffineTransforms(firstFrame, numFrames);
     Rect cropBox = video->getCropBox();
     int vidWidth = video->getWidth();
     int vidHeight = video->getHeight();
-    maxT = video->getFrameCount()-1;
+    setLayout(firstFrame, numFrames);
 
     if (problemLoaded) {
         si = ClpSimplex(false);
@@ -59,26 +94,56 @@ void L1Model::prepare(Video* video)
     }
 
     setObjectives();
+    if (isTranslationTransform) {
+        setTranslationBounds(); // Restrict transformation to 2 DOF
+    }
 
-    matrix.setDimensions(0,getWidth());
-    setSmoothnessConstraints(frameMotions); // Define what motion is permissible
-    setInclusionConstraints(cropBox, vidWidth, vidHeight);   // Prevent crop window from leaving frame
-    setProximityConstraints();  // Prevent the crop window from varying too greatly
+    int pairs = maxT-1;
+    if (compactSimilarity) {
+        // Only a, b, e and f are variables, c = -b and d = a hold by construction.
+        // This needs no similarity rows and only two proximity rows per frame
+        int smoothnessFirstRow = 0, smoothnessElement = 0;
+        int inclusionFirstRow = smoothnessFirstRow + 8*pairs, inclusionElement = smoothnessElement + 32*pairs;
+        int proximityFirstRow = inclusionFirstRow + 8*maxT, proximityElement = inclusionElement + 24*maxT;
+        allocateConstraints(proximityFirstRow + 2*pairs, proximityElement + 2*pairs);
+        setCompactSmoothnessConstraints(frameMotions, smoothnessFirstRow, smoothnessElement);
+        setCompactInclusionConstraints(cropBox, vidWidth, vidHeight, inclusionFirstRow, inclusionElement);
+        setCompactProximityConstraints(proximityFirstRow, proximityElement);
+        buildMatrix();
+        return;
+    }
 
+    // The size of every constraint block is known up front, so the matrix is
+    // allocated once and each block fills its own range of rows and elements
+    int smoothnessFirstRow = 0, smoothnessElement = 0;
+    int inclusionFirstRow = smoothnessFirstRow + 12*pairs, inclusionElement = smoothnessElement + 48*pairs;
+    int proximityFirstRow = inclusionFirstRow + 8*maxT, proximityElement = inclusionElement + 24*maxT;
+    int similarityFirstRow = proximityFirstRow + 6*pairs, similarityElement = proximityElement + 8*pairs;
+    int numRows = similarityFirstRow, numElements = similarityElement;
     if (isSimilarityTransform) {
-        setSimilarityConstraints(); // Restrict transformation to 4 DOF
+        numRows += 2*maxT;
+        numElements += 4*maxT;
     }
+    allocateConstraints(numRows, numElements);
 
-    for (uint i = 0; i < constraints.size(); i++) {
-        matrix.appendRow(constraints[i]);
+    setSmoothnessConstraints(frameMotions, smoothnessFirstRow, smoothnessElement); // Define what motion is permissible
+    setInclusionConstraints(cropBox, vidWidth, vidHeight, inclusionFirstRow, inclusionElement);   // Prevent crop window from leaving frame
+    setProximityConstraints(proximityFirstRow, proximityElement);  // Prevent the crop window from varying too greatly
+
+    if (isSimilarityTransform) {
+        setSimilarityConstraints(similarityFirstRow, similarityElement); // Restrict transformation to 4 DOF
     }
 
+    buildMatrix();
 }
 
 bool L1Model::solve()
 {
     qDebug() << "L1Model::solve() - Solving ";
+    QElapsedTimer timer;
+    timer.start();
     si.loadProblem(matrix,&colLb[0],&colUb[0],&objectiveCoefficients[0],&constraintsLb[0],&constraintsUb[0]);
+    problemLoaded = true;
 
     ClpDualRowSteepest dualSteep(1);
     si.setDualRowPivotAlgorithm(dualSteep);
@@ -86,29 +151,104 @@ bool L1Model::solve()
     ClpPrimalColumnSteepest primalSteep(1);
     si.setPrimalColumnPivotAlgorithm(primalSteep);
 
-    si.scaling(1);
+    si.scaling(scaling);
+
+    // A basis from a problem of the same shape is usually close to optimal.
+    // Presolve would discard it, and only the dual simplex can start from it
+    bool warm = !warmStart.empty() && (int) warmStart.size() == si.numberRows()+si.numberColumns();
+    if (warm) {
+        qDebug() << "L1Model::solve - Starting from a cached basis";
+        si.copyinStatus(&warmStart[0]);
+    }
 
+    iterations = 0;
+    cleanupIterations = 0;
+    cleanupTime = 0;
     ClpPresolve presolveInfo;
-    Ptr<ClpSimplex> presolvedModel = presolveInfo.presolvedModel(si);
+    Ptr<ClpSimplex> presolvedModel;
+    if (presolve && !warm) {
+        presolvedModel = presolveInfo.presolvedModel(si);
+    }
 
     if (!presolvedModel.empty())
     {
-        presolvedModel->dual();
+        runStrategy(*presolvedModel);
+        iterations = presolvedModel->numberIterations();
+        solveTime = timer.elapsed();
+        // Postsolve can leave the original problem slightly infeasible
+        timer.restart();
         presolveInfo.postsolve(true);
         si.checkSolution();
         si.primal(1);
+        cleanupIterations = si.numberIterations();
+        cleanupTime = timer.elapsed();
+        hasBasis = true;
     }
-    else
+    else if (warm)
     {
         si.dual();
-        si.checkSolution();
-        si.primal(1);
+        iterations = si.numberIterations();
+        solveTime = timer.elapsed();
+        hasBasis = true;
+    }
+    else
+    {
+        runStrategy(si);
+        iterations = si.numberIterations();
+        solveTime = timer.elapsed();
+        hasBasis = strategy != BARRIER;
+    }
+    return reportSolution();
+}
+
+bool L1Model::resolve()
+{
+    assert(problemLoaded);
+    qDebug() << "L1Model::resolve - Solving from previous basis";
+    QElapsedTimer timer;
+    timer.start();
+    // Presolve would throw the basis away, the changed rows are few enough without it
+    if (!hasBasis) {
+        si.allSlackBasis();
+    }
+    si.dual();
+    hasBasis = true;
+    iterations = si.numberIterations();
+    cleanupIterations = 0;
+    cleanupTime = 0;
+    solveTime = timer.elapsed();
+    return reportSolution();
+}
+
+void L1Model::runStrategy(ClpSimplex& model)
+{
+    switch (strategy) {
+    case PRIMAL:
+        model.primal();
+        break;
+    case BARRIER:
+        model.barrier(false);
+        break;
+    case BARRIER_CROSSOVER:
+        model.barrier(true);
+        break;
+    default:
+        model.dual();
+        break;
     }
+}
 
+bool L1Model::reportSolution()
+{
+    const char* strategyNames[] = {"dual", "primal", "barrier", "barrier with crossover"};
+    qDebug() << "L1Model::reportSolution -" << strategyNames[strategy] << (presolve ? "with" : "without") << "presolve, scaling" << scaling
+             << ":" << iterations << "iterations in" << solveTime << "ms, cleanup" << cleanupIterations
+             << "iterations in" << cleanupTime << "ms, for" << si.numberRows() << "rows,"
+             << si.numberColumns() << "columns and" << si.getNumElements() << "elements";
     if (si.isProvenOptimal()) {
-        qDebug() << "L1Model::solve - Found optimal solution";
+        qDebug() << "L1Model::reportSolution - Found optimal solution";
     } else {
-        qDebug() << "L1Model::solve - Did not find optimal solution";
+        qDebug() << "L1Model::reportSolution - Did not find optimal solution";
         if (si.isProvenPrimalInfeasible())
         qDebug() << "Problem is proven to be infeasible.";
         if (si.isProvenDualInfeasible())
@@ -124,9 +264,81 @@ bool L1Model::solve()
 
 // ACCESS RESULTS
 double L1Model::getVariableSolution(int t, char ch)
+{
+    const double * sols = cachedSolution.empty() ? si.getColSolution() : &cachedSolution[0];
+    if (compactSimilarity && ch == 'c') {
+        return -sols[toIndex(t-firstFrame,'b')];
+    } else if (compactSimilarity && ch == 'd') {
+        return sols[toIndex(t-firstFrame,'a')];
+    }
+    return sols[toIndex(t-firstFrame,ch)];
+}
+
+vector<double> L1Model::getColumnSolution()
 {
     const double * sols = si.getColSolution();
-    return sols[toIndex(t-1,ch)];
+    return vector<double>(sols, sols+si.numberColumns());
+}
+
+vector<unsigned char> L1Model::getBasis()
+{
+    const unsigned char * status = si.statusArray();
+    if (!status || !hasBasis) {
+        return vector<unsigned char>();
+    }
+    return vector<unsigned char>(status, status+si.numberRows()+si.numberColumns());
+}
+
+void L1Model::setColumnSolution(const vector<double>& columns)
+{
+    assert((int) columns.size() == getWidth());
+    cachedSolution = columns;
+}
+
+void L1Model::setWarmStart(const vector<unsigned char>& basis)
+{
+    warmStart = basis;
+}
+
+// Clp keeps the column statuses first, then the rows in the block order of prepare.
+// Frames entering the horizon repeat the statuses of the last frame
+vector<unsigned char> L1Model::getShiftedBasis(int frames)
+{
+    vector<unsigned char> basis = getBasis();
+    if (basis.empty()) {
+        return basis;
+    }
+    int pairs = maxT-1;
+    shiftStatus(basis, 0, varPerFrame+slackVarPerFrame, maxT, frames);
+    int row = si.numberColumns();
+    if (compactSimilarity) {
+        shiftStatus(basis, row, 8, pairs, frames);
+        row += 8*pairs;
+        shiftStatus(basis, row, 8, maxT, frames);
+        row += 8*maxT;
+        shiftStatus(basis, row, 2, pairs, frames);
+        return basis;
+    }
+    shiftStatus(basis, row, 12, pairs, frames);
+    row += 12*pairs;
+    shiftStatus(basis, row, 8, maxT, frames);
+    row += 8*maxT;
+    shiftStatus(basis, row, 6, pairs, frames);
+    row += 6*pairs;
+    if (isSimilarityTransform) {
+        shiftStatus(basis, row, 2, maxT, frames);
+    }
+    return basis;
+}
+
+void L1Model::shiftStatus(vector<unsigned char>& status, int start, int blockSize, int blocks, int shift)
+{
+    for (int b = 0; b < blocks; b++) {
+        int from = std::min(b+shift, blocks-1);
+        for (int i = 0; i < blockSize; i++) {
+            status[start + b*blockSize + i] = status[start + from*blockSize + i];
+        }
+    }
 }
 
 // SET OBJECTIVE
@@ -134,13 +346,16 @@ void L1Model::setObjectives()
 {
     qDebug() << "L1Model::setObjectives - Setting Objectives";
     int width = getWidth();
-    objectiveCoefficients.reserve(width);
-    colLb.reserve(width);
-    colUb.reserve(width);
+    objectiveCoefficients.assign(width, 0);
+    colLb.assign(width, 0);
+    colUb.assign(width, 0);
     for (int t = 0; t < maxT; t++) {
         for (int i = 0; i < varPerFrame; i++) {
             objectiveCoefficients[toIndex(t,i)] = 0;      // We don't mind about what p is
             objectiveCoefficients[toSlackIndex(t,i)] = 1; // Minimise the sum of the slacks
+            if (compactSimilarity && i < 2) {
+                objectiveCoefficients[toSlackIndex(t,i)] = 2; // The slacks of a and b also stand for d and c
+            }
             colLb[toIndex(t,i)] = -1 * osiInterface.getInfinity(); // p can be as small
             colLb[toSlackIndex(t,i)] = 0;                 // slacks must be positive
             colUb[toIndex(t,i)] = osiInterface.getInfinity();      // p can be as big as we like
@@ -150,202 +365,227 @@ void L1Model::setObjectives()
 
     // Anchor first movement to be at location of crop window
     for (char i = 'a'; i <= 'f' ; i++) {
-        if (i == 'a' || i == 'd') {
-            colLb[toIndex(0,i)] = 1;
-            colUb[toIndex(0,i)] = 1;
-        } else {
-            colLb[toIndex(0,i)] = 0;
-            colUb[toIndex(0,i)] = 0;
+        if (!isVariable(i)) {
+            continue;
         }
+        colLb[toIndex(0,i)] = getElem(anchor,i);
+        colUb[toIndex(0,i)] = getElem(anchor,i);
     }
 }
 
 // CONSTRAINT SETTERS
-void L1Model::setSmoothnessConstraints(vector<Mat>& fs)
+void L1Model::allocateConstraints(int numRows, int numElements)
+{
+    rowIndices.assign(numElements, 0);
+    colIndices.assign(numElements, 0);
+    elements.assign(numElements, 0);
+    constraintsLb.assign(numRows, 0);
+    constraintsUb.assign(numRows, 0);
+}
+
+void L1Model::buildMatrix()
+{
+    matrix = CoinPackedMatrix(true, &rowIndices[0], &colIndices[0], &elements[0], elements.size());
+    // Columns only used in the objective (the last slacks) are not in the triplets
+    matrix.setDimensions(constraintsLb.size(), getWidth());
+}
+
+void L1Model::setSmoothnessConstraints(const Mat& fs, int row, int element)
 {
     qDebug() << "L1Model::setSmoothnessConstraints - Setting Smoothness Constraints";
-    constraints.reserve(constraints.size()+((maxT-1)*2*6));
-    constraintsLb.reserve(constraintsLb.size()+((maxT-1)*2*6));
-    constraintsUb.reserve(constraintsUb.size()+((maxT-1)*2*6));
     // F(t) = mapping from It to It-1
     for (int t = 0; t < maxT-1; t++) {
-        const Mat& aff = fs[t+1]; // F = F(t+1)
+        Mat aff = fs.rowRange(2*(t+1), 2*(t+2)); // F = F(t+1)
         // 1 = B(t+1)
         // 2 = F(t+1)
         // 3 = B(t)
         // slack a: a2a1 + b2c1 - a3
-        CoinPackedVector a;
-        a.insert(toIndex(t+1,'a'), getElem(aff,'a'));
-        a.insert(toIndex(t+1, 'c'), getElem(aff, 'b'));
-        a.insert(toIndex(t, 'a'), -1);
-        CoinPackedVector a2(a);
-        a.insert(toSlackIndex(t, 'a'), -1);
-        a2.insert(toSlackIndex(t, 'a'), 1);
+        setSmoothnessRows(row, element, t, 'a', 'a', getElem(aff,'a'), 'c', getElem(aff,'b'), 0);
         // slack b: a2b1 + b2d1 - b3
-        CoinPackedVector b;
-        b.insert(toIndex(t+1,'b'), getElem(aff,'a'));
-        b.insert(toIndex(t+1, 'd'), getElem(aff, 'b'));
-        b.insert(toIndex(t, 'b'), -1);
-        CoinPackedVector b2(b);
-        b.insert(toSlackIndex(t, 'b'), -1);
-        b2.insert(toSlackIndex(t, 'b'), 1);
+        setSmoothnessRows(row, element, t, 'b', 'b', getElem(aff,'a'), 'd', getElem(aff,'b'), 0);
         // slack c: c2a1 + d2c1 - c3
-        CoinPackedVector c;
-        c.insert(toIndex(t+1,'a'), getElem(aff,'c'));
-        c.insert(toIndex(t+1, 'c'), getElem(aff, 'd'));
-        c.insert(toIndex(t, 'c'), -1);
-        CoinPackedVector c2(c);
-        c.insert(toSlackIndex(t, 'c'), -1);
-        c2.insert(toSlackIndex(t, 'c'), 1);
+        setSmoothnessRows(row, element, t, 'c', 'a', getElem(aff,'c'), 'c', getElem(aff,'d'), 0);
         // slack d: c2b1 + d2d1 - d3
-        CoinPackedVector d;
-        d.insert(toIndex(t+1,'b'), getElem(aff,'c'));
-        d.insert(toIndex(t+1, 'd'), getElem(aff, 'd'));
-        d.insert(toIndex(t, 'd'), -1);
-        CoinPackedVector d2(d);
-        d.insert(toSlackIndex(t, 'd'), -1);
-        d2.insert(toSlackIndex(t, 'd'), 1);
+        setSmoothnessRows(row, element, t, 'd', 'b', getElem(aff,'c'), 'd', getElem(aff,'d'), 0);
         // slack e: a2e1 + b2f1 + e2 - e3
-        CoinPackedVector e;
-        e.insert(toIndex(t+1,'e'), getElem(aff,'a'));
-        e.insert(toIndex(t+1, 'f'), getElem(aff, 'b'));
-        e.insert(toIndex(t, 'e'), -1);
-        CoinPackedVector e2(e);
-        e.insert(toSlackIndex(t, 'e'), -1);
-        e2.insert(toSlackIndex(t, 'e'), 1);
+        setSmoothnessRows(row, element, t, 'e', 'e', getElem(aff,'a'), 'f', getElem(aff,'b'), getElem(aff,'e'));
         // slack f: c2e1 + d2f1 + f2 - f3
-        CoinPackedVector f;
-        f.insert(toIndex(t+1,'e'), getElem(aff,'c'));
-        f.insert(toIndex(t+1, 'f'), getElem(aff, 'd'));
-        f.insert(toIndex(t, 'f'), -1);
-        CoinPackedVector f2(f);
-        f.insert(toSlackIndex(t, 'f'), -1);
-        f2.insert(toSlackIndex(t, 'f'), 1);
-        constraints.push_back(a);
-        constraints.push_back(a2);
-        constraints.push_back(b);
-        constraints.push_back(b2);
-        constraints.push_back(c);
-        constraints.push_back(c2);
-        constraints.push_back(d);
-        constraints.push_back(d2);
-        constraints.push_back(e);
-        constraints.push_back(e2);
-        constraints.push_back(f);
-        constraints.push_back(f2);
-
-        for (int i = 0; i < 4; i++) {
-            constraintsLb.push_back(-1 * osiInterface.getInfinity());
-            constraintsUb.push_back(0);
-            constraintsLb.push_back(0);
-            constraintsUb.push_back(osiInterface.getInfinity());
-        }
-        constraintsLb.push_back(-1 * osiInterface.getInfinity());
-        constraintsUb.push_back(-1 * getElem(aff,'e'));
-        constraintsLb.push_back(-1 * getElem(aff,'e'));
-        constraintsUb.push_back(osiInterface.getInfinity());
+        setSmoothnessRows(row, element, t, 'f', 'e', getElem(aff,'c'), 'f', getElem(aff,'d'), getElem(aff,'f'));
+    }
+}
 
-        constraintsLb.push_back(-1 * osiInterface.getInfinity());
-        constraintsUb.push_back(-1 * getElem(aff,'f'));
-        constraintsLb.push_back(-1 * getElem(aff,'f'));
-        constraintsUb.push_back(osiInterface.getInfinity());
+// Writes the pair of rows -slack <= k1*p1 + k2*p2 - p3 + constant <= slack
+// for variable v, advancing row and element past them
+void L1Model::setSmoothnessRows(int& row, int& element, int t, char v, char v1, double k1, char v2, double k2, double constant)
+{
+    double inf = osiInterface.getInfinity();
+    for (int side = 0; side < 2; side++) {
+        setElement(element, row, toIndex(t+1, v1), k1);
+        setElement(element, row, toIndex(t+1, v2), k2);
+        setElement(element, row, toIndex(t, v), -1);
+        if (side == 0) {
+            setElement(element, row, toSlackIndex(t, v), -1);
+            setConstraintBounds(row, -inf, -constant);
+        } else {
+            setElement(element, row, toSlackIndex(t, v), 1);
+            setConstraintBounds(row, -constant, inf);
+        }
+        row++;
     }
 }
 
-void L1Model::setProximityConstraints()
+void L1Model::setProximityConstraints(int row, int element)
 {
     qDebug() << "L1Model::setProximityConstraints";
-    constraints.reserve(constraints.size()+((maxT-1)*6));
-    constraintsLb.reserve(constraintsLb.size()+((maxT-1)*6));
-    constraintsUb.reserve(constraintsUb.size()+((maxT-1)*6));
     for (int t = 0; t < maxT-1; t++) {
-         CoinPackedVector v;
-         v.insert(toIndex(t, 'a'), 1);
-         constraintsLb.push_back(0.9);
-         constraintsUb.push_back(1.1);
-         constraints.push_back(v);
-         CoinPackedVector v2;
-         v2.insert(toIndex(t, 'd'), 1);
-         constraintsLb.push_back(0.9);
-         constraintsUb.push_back(1.1);
-         constraints.push_back(v2);
-         CoinPackedVector v3;
-         v3.insert(toIndex(t, 'b'), 1);
-         constraintsLb.push_back(-0.1);
-         constraintsUb.push_back(0.1);
-         constraints.push_back(v3);
-         CoinPackedVector v4;
-         v4.insert(toIndex(t, 'c'), 1);
-         constraintsLb.push_back(-0.1);
-         constraintsUb.push_back(0.1);
-         constraints.push_back(v4);
-         CoinPackedVector v5;
-         v5.insert(toIndex(t, 'b'), 1);
-         v5.insert(toIndex(t, 'c'), 1);
-         constraintsLb.push_back(-0.05);
-         constraintsUb.push_back(0.05);
-         constraints.push_back(v5);
-         CoinPackedVector v6;
-         v6.insert(toIndex(t, 'a'), 1);
-         v6.insert(toIndex(t, 'd'), -1);
-         constraintsLb.push_back(-0.1);
-         constraintsUb.push_back(0.1);
-         constraints.push_back(v6);
-    }
-}
-
-void L1Model::setInclusionConstraints(Rect cropBox, int videoWidth, int videoHeight) {
+        setElement(element, row, toIndex(t, 'a'), 1);
+        setConstraintBounds(row++, 0.9, 1.1);
+        setElement(element, row, toIndex(t, 'd'), 1);
+        setConstraintBounds(row++, 0.9, 1.1);
+        setElement(element, row, toIndex(t, 'b'), 1);
+        setConstraintBounds(row++, -0.1, 0.1);
+        setElement(element, row, toIndex(t, 'c'), 1);
+        setConstraintBounds(row++, -0.1, 0.1);
+        setElement(element, row, toIndex(t, 'b'), 1);
+        setElement(element, row, toIndex(t, 'c'), 1);
+        setConstraintBounds(row++, -0.05, 0.05);
+        setElement(element, row, toIndex(t, 'a'), 1);
+        setElement(element, row, toIndex(t, 'd'), -1);
+        setConstraintBounds(row++, -0.1, 0.1);
+    }
+}
+
+void L1Model::setInclusionConstraints(Rect cropBox, int videoWidth, int videoHeight, int row, int element) {
     qDebug() << "L1Model::setInclusionConstraints - Ensuring cropbox stays within frame";
-    // Number of Constraints
-    int numConstraints = 2 * 4 * maxT;
-    constraints.reserve(constraints.size()+numConstraints);
-    constraintsLb.reserve(constraintsLb.size()+numConstraints);
-    constraintsUb.reserve(constraintsUb.size()+numConstraints);
+    inclusionRow = row;
     // For each pt
     for (int t = 0; t < maxT; t++) {
         // For each corner
         for (int x = cropBox.x; x <= cropBox.x+cropBox.width; x+=cropBox.width) {
             for (int y = cropBox.y; y <= cropBox.y+cropBox.height; y+=cropBox.height) {
                 //Set inclusion constraints
-                CoinPackedVector const1;
-                const1.insert(toIndex(t, 'a'), x);
-                const1.insert(toIndex(t, 'b'), y);
-                const1.insert(toIndex(t, 'e'), 1);
-                constraintsLb.push_back(0);
-                constraintsUb.push_back(videoWidth);
-                constraints.push_back(const1);
-                CoinPackedVector const2;
-                const2.insert(toIndex(t, 'c'), x);
-                const2.insert(toIndex(t, 'd'), y);
-                const2.insert(toIndex(t,'f'), 1);
-                constraintsLb.push_back(0);
-                constraintsUb.push_back(videoHeight);
-                constraints.push_back(const2);
+                setElement(element, row, toIndex(t, 'a'), x);
+                setElement(element, row, toIndex(t, 'b'), y);
+                setElement(element, row, toIndex(t, 'e'), 1);
+                setConstraintBounds(row++, 0, videoWidth);
+                setElement(element, row, toIndex(t, 'c'), x);
+                setElement(element, row, toIndex(t, 'd'), y);
+                setElement(element, row, toIndex(t, 'f'), 1);
+                setConstraintBounds(row++, 0, videoHeight);
+            }
+        }
+    }
+}
+
+// Similarity projection of F: a = d, b = -c. Exact for similarity motion models
+void L1Model::getSimilarityElems(const Mat& affine, double& a, double& b)
+{
+    a = (getElem(affine,'a') + getElem(affine,'d')) / 2;
+    b = (getElem(affine,'b') - getElem(affine,'c')) / 2;
+}
 
+// As setSmoothnessConstraints with c = -b and d = a. The residuals of c and d
+// equal those of b and a, which is why their slacks count twice
+void L1Model::setCompactSmoothnessConstraints(const Mat& fs, int row, int element)
+{
+    qDebug() << "L1Model::setCompactSmoothnessConstraints - Setting Smoothness Constraints";
+    for (int t = 0; t < maxT-1; t++) {
+        Mat aff = fs.rowRange(2*(t+1), 2*(t+2)); // F = F(t+1)
+        double a, b;
+        getSimilarityElems(aff, a, b);
+        // slack a: a2a1 - b2b1 - a3
+        setSmoothnessRows(row, element, t, 'a', 'a', a, 'b', -b, 0);
+        // slack b: a2b1 + b2a1 - b3
+        setSmoothnessRows(row, element, t, 'b', 'b', a, 'a', b, 0);
+        // slack e: a2e1 + b2f1 + e2 - e3
+        setSmoothnessRows(row, element, t, 'e', 'e', a, 'f', b, getElem(aff,'e'));
+        // slack f: -b2e1 + a2f1 + f2 - f3
+        setSmoothnessRows(row, element, t, 'f', 'e', -b, 'f', a, getElem(aff,'f'));
+    }
+}
+
+void L1Model::setCompactInclusionConstraints(Rect cropBox, int videoWidth, int videoHeight, int row, int element) {
+    qDebug() << "L1Model::setCompactInclusionConstraints - Ensuring cropbox stays within frame";
+    inclusionRow = row;
+    for (int t = 0; t < maxT; t++) {
+        for (int x = cropBox.x; x <= cropBox.x+cropBox.width; x+=cropBox.width) {
+            for (int y = cropBox.y; y <= cropBox.y+cropBox.height; y+=cropBox.height) {
+                setElement(element, row, toIndex(t, 'a'), x);
+                setElement(element, row, toIndex(t, 'b'), y);
+                setElement(element, row, toIndex(t, 'e'), 1);
+                setConstraintBounds(row++, 0, videoWidth);
+                setElement(element, row, toIndex(t, 'b'), -x);
+                setElement(element, row, toIndex(t, 'a'), y);
+                setElement(element, row, toIndex(t, 'f'), 1);
+                setConstraintBounds(row++, 0, videoHeight);
+            }
+        }
+    }
+}
+
+// a - d and b + c are zero, so only the bounds on a and b remain
+void L1Model::setCompactProximityConstraints(int row, int element)
+{
+    qDebug() << "L1Model::setCompactProximityConstraints";
+    for (int t = 0; t < maxT-1; t++) {
+        setElement(element, row, toIndex(t, 'a'), 1);
+        setConstraintBounds(row++, 0.9, 1.1);
+        setElement(element, row, toIndex(t, 'b'), 1);
+        setConstraintBounds(row++, -0.1, 0.1);
+    }
+}
+
+void L1Model::updateCropBox(Rect cropBox, int videoWidth, int videoHeight) {
+    qDebug() << "L1Model::updateCropBox - Moving inclusion constraints";
+    assert(problemLoaded);
+    // Same row order as setInclusionConstraints and setCompactInclusionConstraints
+    int row = inclusionRow;
+    for (int t = 0; t < maxT; t++) {
+        for (int x = cropBox.x; x <= cropBox.x+cropBox.width; x+=cropBox.width) {
+            for (int y = cropBox.y; y <= cropBox.y+cropBox.height; y+=cropBox.height) {
+                si.modifyCoefficient(row, toIndex(t, 'a'), x);
+                si.modifyCoefficient(row, toIndex(t, 'b'), y);
+                si.setRowBounds(row, 0, videoWidth);
+                row++;
+                if (compactSimilarity) {
+                    si.modifyCoefficient(row, toIndex(t, 'b'), -x);
+                    si.modifyCoefficient(row, toIndex(t, 'a'), y);
+                } else {
+                    si.modifyCoefficient(row, toIndex(t, 'c'), x);
+                    si.modifyCoefficient(row, toIndex(t, 'd'), y);
+                }
+                si.setRowBounds(row, 0, videoHeight);
+                row++;
             }
         }
     }
 }
 
-void L1Model::setSimilarityConstraints() {
+void L1Model::setSimilarityConstraints(int row, int element) {
     qDebug() << "L1Model::setSimilarityConstraints - Ensuring only 4 DOF";
-    int numConstraints = 2 * maxT;
-    constraints.reserve(constraints.size()+numConstraints);
-    constraintsLb.reserve(constraintsLb.size()+numConstraints);
-    constraintsUb.reserve(constraintsUb.size()+numConstraints);
-    for (int i = 0; i < maxT; i++) {
-        CoinPackedVector s1;
-        s1.insert(toIndex(i,'a'),1);
-        s1.insert(toIndex(i,'d'),-1);
-        constraints.push_back(s1);
-        constraintsLb.push_back(0);
-        constraintsUb.push_back(0);
-        CoinPackedVector s2;
-        s2.insert(toIndex(i,'b'),1);
-        s2.insert(toIndex(i,'c'),1);
-        constraints.push_back(s2);
-        constraintsLb.push_back(0);
-        constraintsUb.push_back(0);
+    for (int t = 0; t < maxT; t++) {
+        setElement(element, row, toIndex(t,'a'), 1);
+        setElement(element, row, toIndex(t,'d'), -1);
+        setConstraintBounds(row++, 0, 0);
+        setElement(element, row, toIndex(t,'b'), 1);
+        setElement(element, row, toIndex(t,'c'), 1);
+        setConstraintBounds(row++, 0, 0);
+    }
+}
+
+// Fixes the linear part of every update transform to the identity.
+// Presolve removes the fixed columns before the solve
+void L1Model::setTranslationBounds() {
+    qDebug() << "L1Model::setTranslationBounds - Ensuring only 2 DOF";
+    for (int t = 0; t < maxT; t++) {
+        for (char i = 'a'; i <= 'd'; i++) {
+            if (!isVariable(i)) {
+                continue;
+            }
+            double value = (i == 'a' || i == 'd') ? 1 : 0;
+            colLb[toIndex(t,i)] = value;
+            colUb[toIndex(t,i)] = value;
+        }
     }
 }
 
@@ -379,8 +619,22 @@ int L1Model::toCol(char c)
 
 int L1Model::toIndex(int t, char v)
 {
-    int var = v - 'a';
-    return toIndex(t,var);
+    return toIndex(t,toVariable(v));
+}
+
+// Position of a parameter within a frame's variables
+int L1Model::toVariable(char v)
+{
+    assert(isVariable(v));
+    if (compactSimilarity) {
+        return v == 'a' ? 0 : (v == 'b' ? 1 : v - 'c'); // a, b, e, f
+    }
+    return v - 'a';
+}
+
+bool L1Model::isVariable(char v)
+{
+    return !compactSimilarity || (v != 'c' && v != 'd');
 }
 
 int L1Model::toIndex(int t, int var)
@@ -390,8 +644,7 @@ int L1Model::toIndex(int t, int var)
 
 int L1Model::toSlackIndex(int t, char v)
 {
-    int var = v - 'a';
-    return toSlackIndex(t, var);
+    return toSlackIndex(t, toVariable(v));
 }
 
 int L1Model::toSlackIndex(int t, int var)
@@ -5,6 +5,7 @@
 #include <coin/CoinModel.hpp>
 #include <coin/OsiClpSolverInterface.hpp>
 #include <opencv2/core/core.hpp>
+#include <QtGlobal>
 
 using namespace std;
 using namespace cv;
@@ -13,13 +14,38 @@ using namespace cv;
 class L1Model
 {
 public:
+    // Algorithm used for a full solve, re-solves always use the dual simplex.
+    // BARRIER runs the interior point method alone and ends inside the feasible
+    // region with no basis, BARRIER_CROSSOVER then moves to a vertex and a basis.
+    // After presolve, every strategy is followed by a primal cleanup of the
+    // postsolved problem, which is timed separately
+    enum Strategy {DUAL, PRIMAL, BARRIER, BARRIER_CROSSOVER};
+
     L1Model(int dof = 4);
-    ~L1Model();
+    virtual ~L1Model();
 
     int getWidth();
 
     bool solve();
+
+    // Re-solves the loaded problem with the dual simplex, starting from the
+    // optimal basis of the previous solve
+    bool resolve();
+
+    // Moves the inclusion constraints to a new crop box in the loaded problem
+    virtual void updateCropBox(Rect cropBox, int videoWidth, int videoHeight);
     double getVariableSolution(int frame, char ch);
+    double getObjectiveValue() {return si.objectiveValue();}
+
+    void setStrategy(Strategy strategy) {this->strategy = strategy;}
+    void setScaling(int scaling) {this->scaling = scaling;} // Clp scaling mode, 0 to 4
+    void setPresolve(bool presolve) {this->presolve = presolve;}
+
+    // Statistics of the last solve, of the strategy and of the cleanup after postsolve
+    int getIterations() const {return iterations;}
+    qint64 getSolveTime() const {return solveTime;}
+    int getCleanupIterations() const {return cleanupIterations;}
+    qint64 getCleanupTime() const {return cleanupTime;}
 
     static int toRow(char c);
     static int toCol(char c);
@@ -31,6 +57,32 @@ public:
     void writeToFile();
     void prepare(Video* video);
 
+    // Only optimises the path over frames [firstFrame, firstFrame+numFrames)
+    void prepare(Video* video, int firstFrame, int numFrames);
+
+    // Fixes the update transform of the first optimised frame (identity by default)
+    void setAnchor(const Mat& anchor);
+
+    // Sets up the variables for frames [firstFrame, firstFrame+numFrames) without building the problem.
+    // Called by prepare, or before setColumnSolution
+    virtual void setLayout(int firstFrame, int numFrames);
+
+    // Solution and basis of the last solve, so they can be cached
+    vector<double> getColumnSolution();
+    vector<unsigned char> getBasis();
+
+    // Uses a cached solution instead of solving
+    void setColumnSolution(const vector<double>& columns);
+
+    // Starts the next solve from the basis of a problem of the same shape
+    void setWarmStart(const vector<unsigned char>& basis);
+
+    // Basis of the last solve moved forward by the given number of frames, to warm
+    // start the same size problem over a horizon that has slid along the video
+    vector<unsigned char> getShiftedBasis(int frames);
+
+    bool isLoaded() const {return problemLoaded;}
+
 protected:
     ClpSimplex si;
     OsiClpSolverInterface osiInterface;
@@ -38,29 +90,75 @@ protected:
     // Objectives
     vector<double> objectiveCoefficients, colLb, colUb;
 
-    // Constraints
+    // Constraints, in triplet form until the matrix is built
     CoinPackedMatrix matrix;
-    vector<CoinPackedVector> constraints;
+    vector<int> rowIndices, colIndices;
+    vector<double> elements;
     vector<double> constraintsLb, constraintsUb;
 
     int varPerFrame;
     int slackVarPerFrame;
     int maxT;
+    int firstFrame; // Frame corresponding to the first set of variables
+    Mat anchor;
     bool isSimilarityTransform;
+    bool isTranslationTransform;
+    bool compactSimilarity; // Similarity problem with only a, b, e and f per frame
     bool problemLoaded;
+    int inclusionRow; // First row of the inclusion constraints
+
+    // Solver settings and statistics
+    Strategy strategy;
+    int scaling;
+    bool presolve;
+    int iterations;
+    qint64 solveTime; // ms
+    int cleanupIterations;
+    qint64 cleanupTime; // ms
+    bool hasBasis; // False after a barrier without crossover
+
+    vector<double> cachedSolution;
+    vector<unsigned char> warmStart;
 
     double getElem(const Mat& affine, char c);
 
     int toIndex(int t, char variable);
+    int toVariable(char variable);
+    bool isVariable(char variable);
     int toIndex(int t, int variable);
     int toSlackIndex(int t, char variable);
     int toSlackIndex(int t, int variable);
+    bool reportSolution();
+    void runStrategy(ClpSimplex& model);
+    static void shiftStatus(vector<unsigned char>& status, int start, int blockSize, int blocks, int shift);
 
+    // Each constraint block writes its rows and elements starting at the given
+    // offsets, the blocks never overlap
     void setObjectives();
-    void setSmoothnessConstraints(vector<Mat>& originalTransformations);
-    void setInclusionConstraints(Rect cropbox, int videoWidth, int videoHeight);
-    void setProximityConstraints();
-    void setSimilarityConstraints();
+    // The frame motions are stacked as by Video::getAffineTransforms
+    void setSmoothnessConstraints(const Mat& originalTransformations, int row, int element);
+    void setInclusionConstraints(Rect cropbox, int videoWidth, int videoHeight, int row, int element);
+    void setProximityConstraints(int row, int element);
+    void setSimilarityConstraints(int row, int element);
+    void setTranslationBounds();
+    void setCompactSmoothnessConstraints(const Mat& originalTransformations, int row, int element);
+    void setCompactInclusionConstraints(Rect cropbox, int videoWidth, int videoHeight, int row, int element);
+    void setCompactProximityConstraints(int row, int element);
+    void getSimilarityElems(const Mat& affine, double& a, double& b);
+
+    void allocateConstraints(int numRows, int numElements);
+    void buildMatrix();
+    void setSmoothnessRows(int& row, int& element, int t, char v, char v1, double k1, char v2, double k2, double constant);
+    void setElement(int& element, int row, int col, double value) {
+        rowIndices[element] = row;
+        colIndices[element] = col;
+        elements[element] = value;
+        element++;
+    }
+    void setConstraintBounds(int row, double lb, double ub) {
+        constraintsLb[row] = lb;
+        constraintsUb[row] = ub;
+    }
 
 };
 
@@ -1,29 +1,35 @@
 #include "l1salientmodel.h"
 #include "l1model.h"
+#include "tools.h"
 #include <QDebug>
 #include <coin/CoinPackedMatrix.hpp>
-#include <coin/CoinPackedVector.hpp>
 #include <coin/CoinModel.hpp>
 #include <coin/OsiClpSolverInterface.hpp>
 
 L1SalientModel::L1SalientModel(int dof):L1Model(dof)
 {
+    salientRow = 0;
     varPerFrame = 6;
     salientSlackVarPerFrame = 4;
     slackVarPerFrame = varPerFrame+salientSlackVarPerFrame;
 }
 
+void L1SalientModel::setLayout(int firstFrame, int numFrames)
+{
+    this->firstFrame = firstFrame;
+    maxT = numFrames;
+    cachedSolution.clear();
+}
+
 void L1SalientModel::prepare(Video* video, bool centered)
 {
-    maxT = video->getFrameCount()-1;
+    setLayout(1, video->getFrameCount()-1);
 
     // Convert F into G (the inverse of F)
-    vector<Mat> frameMotions = video->getAffineTransforms();
-    vector<Mat> gs;
-    for (uint f = 0; f < frameMotions.size(); f++) {
-        Mat g = Mat::zeros(2,3,DataType<float>::type);
-        cv::invertAffineTransform(frameMotions[f], g);
-        gs.push_back(g.clone());
+    Mat frameMotions = video->getAffineTransforms(1, maxT);
+    Mat gs(frameMotions.size(), frameMotions.type());
+    for (int t = 0; t < maxT; t++) {
+        Mat(Tools::invertAffine(Matx23f(frameMotions.rowRange(2*t, 2*t+2))), false).copyTo(gs.rowRange(2*t, 2*t+2));
     }
     Rect cropBox = video->getCropBox();
     int vidWidth = video->getWidth();
@@ -35,20 +41,35 @@ void L1SalientModel::prepare(Video* video, bool centered)
     }
 
     setObjectives();        // Set the objective equation involving transform params, slack error variables, slack salient variables
-    setSmoothnessConstraints(gs);                            // Define what motion is permissible
-    setInclusionConstraints(cropBox, vidWidth, vidHeight);   // Prevent frame from not containing crop window
-    setSalientConstraints(video,centered);                            // Prevent feature from leaving crop window
-    setProximityConstraints();
+    if (isTranslationTransform) {
+        setTranslationBounds(); // Restrict transformation to 2 DOF
+    }
 
+    // Same layout as L1Model with the salient block after the inclusion block
+    int pairs = maxT-1;
+    int smoothnessFirstRow = 0, smoothnessElement = 0;
+    int inclusionFirstRow = smoothnessFirstRow + 12*pairs, inclusionElement = smoothnessElement + 48*pairs;
+    int salientFirstRow = inclusionFirstRow + 8*maxT, salientElement = inclusionElement + 24*maxT;
+    int proximityFirstRow = salientFirstRow + 4*maxT, proximityElement = salientElement + 16*maxT;
+    int similarityFirstRow = proximityFirstRow + 6*pairs, similarityElement = proximityElement + 8*pairs;
+    int numRows = similarityFirstRow, numElements = similarityElement;
     if (isSimilarityTransform) {
-        setSimilarityConstraints(); // Restrict transformation to 4 DOF
+        numRows += 2*maxT;
+        numElements += 4*maxT;
     }
+    allocateConstraints(numRows, numElements);
 
-    // Load problem into COIN
-    matrix.setDimensions(0,getWidth());
-    for (uint i = 0; i < constraints.size(); i++) {
-        matrix.appendRow(constraints[i]);
+    setSmoothnessConstraints(gs, smoothnessFirstRow, smoothnessElement);                            // Define what motion is permissible
+    setInclusionConstraints(cropBox, vidWidth, vidHeight, inclusionFirstRow, inclusionElement);   // Prevent frame from not containing crop window
+    setSalientConstraints(video, centered, salientFirstRow, salientElement);                       // Prevent feature from leaving crop window
+    setProximityConstraints(proximityFirstRow, proximityElement);
+
+    if (isSimilarityTransform) {
+        setSimilarityConstraints(similarityFirstRow, similarityElement); // Restrict transformation to 4 DOF
     }
+
+    // Load problem into COIN
+    buildMatrix();
     si.loadProblem(matrix,&colLb[0],&colUb[0],&objectiveCoefficients[0],&constraintsLb[0],&constraintsUb[0]);
     problemLoaded = true;
 }
@@ -57,9 +78,9 @@ void L1SalientModel::setObjectives()
 {
     qDebug() << "L1SalientModel::setObjectives - Setting Objectives";
     int width = getWidth();
-    objectiveCoefficients.reserve(width);
-    colLb.reserve(width);
-    colUb.reserve(width);
+    objectiveCoefficients.assign(width, 0);
+    colLb.assign(width, 0);
+    colUb.assign(width, 0);
     for (int t = 0; t < maxT; t++) {
         // Set coefficients and bounds on variables
         for (int i = 0; i < varPerFrame; i++) {
@@ -102,115 +123,129 @@ int L1SalientModel::toSalientSlackIndex(int t, int corner, char component)
     return t*(varPerFrame+slackVarPerFrame)+varPerFrame+varPerFrame+salientVarOffset;
 }
 
-void L1SalientModel::setSalientConstraints(Video* video, bool centered) {
+void L1SalientModel::setSalientConstraints(Video* video, bool centered, int row, int element) {
     qDebug() << "L1SalientModel::setSalientConstraints - Forcing salient feature to stay within crop window";
-    int numConstraints = maxT * 4;
-    constraints.reserve(constraints.size()+numConstraints);
-    constraintsLb.reserve(constraintsLb.size()+numConstraints);
-    constraintsUb.reserve(constraintsUb.size()+numConstraints);
-    Rect cropbox = video->getCropBox();
-    double tlX = centered ? cropbox.x + (0.5 * cropbox.width) - 10 : cropbox.x ;
-    double tlY = centered ? cropbox.y + (0.5 * cropbox.height) - 10 : cropbox.y ;
-    double brX = centered ? cropbox.x + (0.5 * cropbox.width) + 10 : cropbox.x + cropbox.width - 1;
-    double brY = centered ? cropbox.y + (0.5 * cropbox.height) + 10 : cropbox.y + cropbox.height - 1;
+    salientRow = row;
+    double tlX, tlY, brX, brY;
+    getSalientWindow(video->getCropBox(), centered, tlX, tlY, brX, brY);
+    double inf = osiInterface.getInfinity();
     // For each pt
     for (int t = 0; t < maxT; t++) {
         Point2f* salientPoint = video->accessFrameAt(t)->getFeature();
         // Add constraint set for TOP LEFT CORNER
-        CoinPackedVector const1;
-        const1.insert(toIndex(t, 'a'), salientPoint->x);
-        const1.insert(toIndex(t, 'b'), salientPoint->y);
-        const1.insert(toIndex(t, 'e'), 1);
-        const1.insert(toSalientSlackIndex(t,0,'x'), 1);
-        constraintsLb.push_back(tlX);
-        constraintsUb.push_back(osiInterface.getInfinity());
-        constraints.push_back(const1);
-        CoinPackedVector const2;
-        const2.insert(toIndex(t, 'c'), salientPoint->x);
-        const2.insert(toIndex(t, 'd'), salientPoint->y);
-        const2.insert(toIndex(t,'f'), 1);
-        const2.insert(toSalientSlackIndex(t,0,'y'), 1);
-        constraintsLb.push_back(tlY);
-        constraintsUb.push_back(osiInterface.getInfinity());
-        constraints.push_back(const2);
+        setElement(element, row, toIndex(t, 'a'), salientPoint->x);
+        setElement(element, row, toIndex(t, 'b'), salientPoint->y);
+        setElement(element, row, toIndex(t, 'e'), 1);
+        setElement(element, row, toSalientSlackIndex(t,0,'x'), 1);
+        setConstraintBounds(row++, tlX, inf);
+        setElement(element, row, toIndex(t, 'c'), salientPoint->x);
+        setElement(element, row, toIndex(t, 'd'), salientPoint->y);
+        setElement(element, row, toIndex(t, 'f'), 1);
+        setElement(element, row, toSalientSlackIndex(t,0,'y'), 1);
+        setConstraintBounds(row++, tlY, inf);
         // Add constraint set for BOTTOM RIGHT CORNER
-        CoinPackedVector const3;
-        const3.insert(toIndex(t, 'a'), salientPoint->x);
-        const3.insert(toIndex(t, 'b'), salientPoint->y);
-        const3.insert(toIndex(t, 'e'), 1);
-        const3.insert(toSalientSlackIndex(t,1,'x'), -1);
-        constraintsLb.push_back(-1*osiInterface.getInfinity());
-        constraintsUb.push_back(brX);
-        constraints.push_back(const3);
-        CoinPackedVector const4;
-        const4.insert(toIndex(t, 'c'), salientPoint->x);
-        const4.insert(toIndex(t, 'd'), salientPoint->y);
-        const4.insert(toIndex(t,'f'), 1);
-        const4.insert(toSalientSlackIndex(t,1,'y'), -1);
-        constraintsLb.push_back(-osiInterface.getInfinity());
-        constraintsUb.push_back(brY);
-        constraints.push_back(const4);
+        setElement(element, row, toIndex(t, 'a'), salientPoint->x);
+        setElement(element, row, toIndex(t, 'b'), salientPoint->y);
+        setElement(element, row, toIndex(t, 'e'), 1);
+        setElement(element, row, toSalientSlackIndex(t,1,'x'), -1);
+        setConstraintBounds(row++, -inf, brX);
+        setElement(element, row, toIndex(t, 'c'), salientPoint->x);
+        setElement(element, row, toIndex(t, 'd'), salientPoint->y);
+        setElement(element, row, toIndex(t, 'f'), 1);
+        setElement(element, row, toSalientSlackIndex(t,1,'y'), -1);
+        setConstraintBounds(row++, -inf, brY);
     }
 }
 
 // Ensures the frame transformation always contains the Cropbox
-void L1SalientModel::setInclusionConstraints(Rect cropbox, int frameWidth, int frameHeight)
+void L1SalientModel::setInclusionConstraints(Rect cropbox, int frameWidth, int frameHeight, int row, int element)
 {
     qDebug() << "L1SalientModel::setInclusionConstraints - Forcing frame transformations to always include Cropbox";
-    int numFrames = maxT;
-    int numCorners = 4;
-    int numConstraintsPerFramePerCorner = 2;
-    int numConstraints = numFrames * numCorners * numConstraintsPerFramePerCorner;
-    constraints.reserve(constraints.size()+numConstraints);
-    constraintsLb.reserve(constraintsLb.size()+numConstraints);
-    constraintsUb.reserve(constraintsUb.size()+numConstraints);
-    int ct = cropbox.y;
-    int cb = cropbox.y+cropbox.height-1;
-    int cl = cropbox.x;
-    int cr = cropbox.x+cropbox.width-1;
+    inclusionRow = row;
     // For each pt
     for (int t = 0; t < maxT; t++) {
         // For each corner
         for (int corner = 0; corner < 4; corner++) {
             int frameCornerX = (corner % 2 == 0) ? 0 : frameWidth-1;
             int frameCornerY = (corner < 2) ? 0 : frameHeight-1;
-            CoinPackedVector const1;
-            const1.insert(toIndex(t, 'a'),frameCornerX);
-            const1.insert(toIndex(t,'b'), frameCornerY);
-            const1.insert(toIndex(t,'e'),1);
-            constraints.push_back(const1);
-            CoinPackedVector const2;
-            const2.insert(toIndex(t, 'c'),frameCornerX);
-            const2.insert(toIndex(t,'d'), frameCornerY);
-            const2.insert(toIndex(t,'f'),1);
-            constraints.push_back(const2);
-            switch(corner) {
-            case 0:
-                constraintsLb.push_back(-1*osiInterface.getInfinity());
-                constraintsUb.push_back(cl);
-                constraintsLb.push_back(-1*osiInterface.getInfinity());
-                constraintsUb.push_back(ct);
-                break;
-            case 1:
-                constraintsLb.push_back(cr);
-                constraintsUb.push_back(osiInterface.getInfinity());
-                constraintsLb.push_back(-1*osiInterface.getInfinity());
-                constraintsUb.push_back(ct);
-                break;
-            case 2:
-                constraintsLb.push_back(-1*osiInterface.getInfinity());
-                constraintsUb.push_back(cl);
-                constraintsLb.push_back(cb);
-                constraintsUb.push_back(osiInterface.getInfinity());
-                break;
-            case 3:
-                constraintsLb.push_back(cr);
-                constraintsUb.push_back(osiInterface.getInfinity());
-                constraintsLb.push_back(cb);
-                constraintsUb.push_back(osiInterface.getInfinity());
-                break;
+            double lb[2], ub[2];
+            getInclusionBounds(cropbox, corner, lb, ub);
+            setElement(element, row, toIndex(t, 'a'), frameCornerX);
+            setElement(element, row, toIndex(t, 'b'), frameCornerY);
+            setElement(element, row, toIndex(t, 'e'), 1);
+            setConstraintBounds(row++, lb[0], ub[0]);
+            setElement(element, row, toIndex(t, 'c'), frameCornerX);
+            setElement(element, row, toIndex(t, 'd'), frameCornerY);
+            setElement(element, row, toIndex(t, 'f'), 1);
+            setConstraintBounds(row++, lb[1], ub[1]);
+        }
+    }
+}
+
+void L1SalientModel::getInclusionBounds(Rect cropbox, int corner, double* lb, double* ub)
+{
+    int ct = cropbox.y;
+    int cb = cropbox.y+cropbox.height-1;
+    int cl = cropbox.x;
+    int cr = cropbox.x+cropbox.width-1;
+    double inf = osiInterface.getInfinity();
+    switch(corner) {
+    case 0:
+        lb[0] = -inf; ub[0] = cl;
+        lb[1] = -inf; ub[1] = ct;
+        break;
+    case 1:
+        lb[0] = cr; ub[0] = inf;
+        lb[1] = -inf; ub[1] = ct;
+        break;
+    case 2:
+        lb[0] = -inf; ub[0] = cl;
+        lb[1] = cb; ub[1] = inf;
+        break;
+    case 3:
+        lb[0] = cr; ub[0] = inf;
+        lb[1] = cb; ub[1] = inf;
+        break;
+    }
+}
+
+void L1SalientModel::getSalientWindow(Rect cropbox, bool centered, double& tlX, double& tlY, double& brX, double& brY)
+{
+    tlX = centered ? cropbox.x + (0.5 * cropbox.width) - 10 : cropbox.x ;
+    tlY = centered ? cropbox.y + (0.5 * cropbox.height) - 10 : cropbox.y ;
+    brX = centered ? cropbox.x + (0.5 * cropbox.width) + 10 : cropbox.x + cropbox.width - 1;
+    brY = centered ? cropbox.y + (0.5 * cropbox.height) + 10 : cropbox.y + cropbox.height - 1;
+}
+
+void L1SalientModel::updateCropBox(Rect cropbox, int, int)
+{
+    qDebug() << "L1SalientModel::updateCropBox - Moving inclusion bounds";
+    assert(problemLoaded);
+    int row = inclusionRow;
+    for (int t = 0; t < maxT; t++) {
+        for (int corner = 0; corner < 4; corner++) {
+            double lb[2], ub[2];
+            getInclusionBounds(cropbox, corner, lb, ub);
+            for (int i = 0; i < 2; i++) {
+                si.setRowBounds(row++, lb[i], ub[i]);
             }
         }
+    }
+}
 
+void L1SalientModel::updateSalientBounds(Rect cropbox, bool centered)
+{
+    qDebug() << "L1SalientModel::updateSalientBounds - Moving salient window";
+    assert(problemLoaded);
+    double tlX, tlY, brX, brY;
+    getSalientWindow(cropbox, centered, tlX, tlY, brX, brY);
+    double inf = osiInterface.getInfinity();
+    // Same row order as setSalientConstraints
+    for (int t = 0; t < maxT; t++) {
+        int row = salientRow + 4*t;
+        si.setRowBounds(row, tlX, inf);
+        si.setRowBounds(row+1, tlY, inf);
+        si.setRowBounds(row+2, -inf, brX);
+        si.setRowBounds(row+3, -inf, brY);
     }
 }
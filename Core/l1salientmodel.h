@@ -22,6 +22,9 @@ public:
     // This is the entry function
     void prepare(Video* video, bool centered);
 
+    // The salient layout does not change with the DOF
+    void setLayout(int firstFrame, int numFrames);
+
     // Feature Transform Variables, Slack Variables, Salient Slack Variables
     void setObjectives();
 
@@ -30,9 +33,23 @@ public:
 
     // Overrides L1Model function
     // Ensures Cropbox is always within transformed frame.
-    void setInclusionConstraints(Rect cropbox, int videoWidth, int videoHeight);
+    void setInclusionConstraints(Rect cropbox, int videoWidth, int videoHeight, int row, int element);
+
+    void setSalientConstraints(Video* video, bool centered, int row, int element);
+
+    // Change the bounds of the loaded problem, the coefficients of
+    // these rows do not depend on the crop box
+    void updateCropBox(Rect cropbox, int videoWidth, int videoHeight);
+    void updateSalientBounds(Rect cropbox, bool centered);
+
+private:
+    int salientRow; // First row of the salient constraints
+
+    // Bounds of the two inclusion rows of a frame corner
+    void getInclusionBounds(Rect cropbox, int corner, double* lb, double* ub);
 
-    void setSalientConstraints(Video* video, bool centered);
+    // Region the salient feature is kept within
+    static void getSalientWindow(Rect cropbox, bool centered, double& tlX, double& tlY, double& brX, double& brY);
 
 };
 
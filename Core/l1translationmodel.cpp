@@ -0,0 +1,103 @@
+#include "l1translationmodel.h"
+#include "l1model.h"
+#include "frame.h"
+#include <QDebug>
+#include <math.h>
+
+L1TranslationModel::L1TranslationModel(int dof)
+{
+    assert(dof == 2);
+    maxT = 0;
+    firstFrame = 1;
+    anchor = Point2d(0, 0);
+}
+
+void L1TranslationModel::setAnchor(const Mat& anchor)
+{
+    this->anchor = Point2d(anchor.at<float>(L1Model::toRow('e'),L1Model::toCol('e')),
+                           anchor.at<float>(L1Model::toRow('f'),L1Model::toCol('f')));
+}
+
+void L1TranslationModel::prepare(Video* video)
+{
+    prepare(video, 1, video->getFrameCount()-1);
+}
+
+void L1TranslationModel::prepare(Video* video, int firstFrame, int numFrames)
+{
+    assert(firstFrame >= 1 && firstFrame+numFrames <= video->getFrameCount());
+    this->firstFrame = firstFrame;
+    maxT = numFrames;
+    translations.resize(maxT);
+    for (int t = 0; t < maxT; t++) {
+        const Mat& aff = video->getFrameAt(firstFrame+t)->getAffineTransform();
+        translations[t] = Point2d(aff.at<float>(L1Model::toRow('e'),L1Model::toCol('e')),
+                                  aff.at<float>(L1Model::toRow('f'),L1Model::toCol('f')));
+    }
+    // Inclusion constraints of L1Model with a = d = 1 and b = c = 0
+    Rect cropBox = video->getCropBox();
+    lower = Point2d(-cropBox.x, -cropBox.y);
+    upper = Point2d(video->getWidth() - cropBox.x - cropBox.width, video->getHeight() - cropBox.y - cropBox.height);
+}
+
+bool L1TranslationModel::solve()
+{
+    qDebug() << "L1TranslationModel::solve - Solving both axes";
+    vector<double> offsetsX(maxT), offsetsY(maxT), pathX, pathY;
+    for (int t = 0; t < maxT; t++) {
+        offsetsX[t] = translations[t].x;
+        offsetsY[t] = translations[t].y;
+    }
+    solveAxis(anchor.x, offsetsX, lower.x, upper.x, pathX);
+    solveAxis(anchor.y, offsetsY, lower.y, upper.y, pathY);
+    solution.resize(maxT);
+    for (int t = 0; t < maxT; t++) {
+        solution[t] = Point2d(pathX[t], pathY[t]);
+    }
+    return true;
+}
+
+// path(0) = start, minimises sum |path(t) + offsets(t) - path(t-1)|
+// with lower <= path(t) <= upper
+void L1TranslationModel::solveAxis(double start, const vector<double>& offsets, double lower, double upper, vector<double>& path)
+{
+    int n = offsets.size();
+    path.resize(n);
+    if (n == 0) {
+        return;
+    }
+    path[0] = start;
+    double y = start;   // Cumulative path
+    double sum = 0;     // Sum of the offsets so far
+    for (int t = 1; t < n; t++) {
+        sum += offsets[t];
+        y = std::min(std::max(y, lower + sum), upper + sum);
+        path[t] = y - sum;
+    }
+}
+
+double L1TranslationModel::getVariableSolution(int t, char ch)
+{
+    const Point2d& p = solution[t-firstFrame];
+    switch (ch) {
+    case 'a':
+    case 'd':
+        return 1;
+    case 'e':
+        return p.x;
+    case 'f':
+        return p.y;
+    default:
+        return 0;
+    }
+}
+
+double L1TranslationModel::getObjectiveValue()
+{
+    double objective = 0;
+    for (int t = 0; t < maxT-1; t++) {
+        Point2d residual = solution[t+1] + translations[t+1] - solution[t];
+        objective += fabs(residual.x) + fabs(residual.y);
+    }
+    return objective;
+}
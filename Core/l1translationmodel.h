@@ -0,0 +1,53 @@
+#ifndef L1TRANSLATIONMODEL_H
+#define L1TRANSLATIONMODEL_H
+
+#include "video.h"
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+/*
+ *
+ *  The L1Model problem when the update transforms are pure translations.
+ *  The x and y axes no longer interact: along each axis the cumulative
+ *  path y(t) = e(t) + (sum of the frame translations up to t) has to stay
+ *  within a band given by the crop box and its total variation is
+ *  minimised. Moving y only when it leaves the band, and then only to
+ *  the nearest edge, is optimal, so each axis is solved exactly in O(T).
+ *
+ */
+class L1TranslationModel
+{
+public:
+    L1TranslationModel(int dof = 2);
+
+    void setAnchor(const Mat& anchor);
+
+    void prepare(Video* video);
+    void prepare(Video* video, int firstFrame, int numFrames);
+
+    bool solve();
+    double getVariableSolution(int frame, char ch);
+
+    // Same value as the objective of the equivalent L1Model problem
+    double getObjectiveValue();
+
+private:
+    int maxT;
+    int firstFrame;
+    Point2d anchor;
+
+    // Translation of the motion of each frame, from the frame to the one before it
+    vector<Point2d> translations;
+    // Band that keeps the crop box inside the frame
+    Point2d lower, upper;
+
+    vector<Point2d> solution;
+
+    static void solveAxis(double start, const vector<double>& offsets, double lower, double upper, vector<double>& path);
+
+};
+
+#endif // L1TRANSLATIONMODEL_H
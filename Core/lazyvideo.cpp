@@ -0,0 +1,143 @@
+#include "lazyvideo.h"
+#include "frame.h"
+#include "exportplanner.h"
+#include <QRunnable>
+#include <QThread>
+#include <QMutexLocker>
+
+// Renders one frame ahead of the playhead
+class LazyVideo::PrefetchTask : public QRunnable
+{
+public:
+    PrefetchTask(LazyVideo* video, int frameNumber): video(video), frameNumber(frameNumber) {}
+
+    void run() {
+        video->renderFrame(frameNumber);
+    }
+
+private:
+    LazyVideo* video;
+    int frameNumber;
+};
+
+LazyVideo::LazyVideo(const Video* source, int interpolation, int cacheSize, int prefetch, QObject *parent) :
+    Video(source->getFrameCount(), source->getOrigFps(), parent),
+    source(source), interpolation(interpolation), cacheSize(std::max(cacheSize, prefetch+1)), prefetch(prefetch), stopped(false)
+{
+    // The first frame gives the size of the video, so it is rendered straight away
+    appendFrame(new Frame(source->getFrameAt(0)->getOriginalData()(source->getCropBox()), this));
+    for (int f = 1; f < source->getFrameCount(); f++) {
+        appendFrame(new Frame(this));
+    }
+    prefetcher.setMaxThreadCount(std::max(QThread::idealThreadCount()-1, 1));
+    QMutexLocker locker(&cacheMutex);
+    prefetchAfter(0);
+}
+
+LazyVideo::~LazyVideo()
+{
+    prefetcher.waitForDone();
+}
+
+const Frame* LazyVideo::getFrameAt(int frameNumber) const
+{
+    const_cast<LazyVideo*>(this)->require(frameNumber);
+    return Video::getFrameAt(frameNumber);
+}
+
+Frame* LazyVideo::accessFrameAt(int frameNumber)
+{
+    require(frameNumber);
+    return Video::accessFrameAt(frameNumber);
+}
+
+Mat LazyVideo::getImageAt(int frameNumber) const
+{
+    LazyVideo* self = const_cast<LazyVideo*>(this);
+    self->require(frameNumber);
+    // The image is shared under the cache lock, so it can not be evicted while it is
+    // taken. A frame evicted again before that is required once more
+    QMutexLocker locker(&self->cacheMutex);
+    while (frameNumber > 0 && !recent.contains(frameNumber) && !stopped) {
+        locker.unlock();
+        self->require(frameNumber);
+        locker.relock();
+    }
+    if (frameNumber > 0 && !recent.contains(frameNumber)) {
+        return Video::getImageAt(0);
+    }
+    return Video::getImageAt(frameNumber);
+}
+
+void LazyVideo::stop()
+{
+    {
+        QMutexLocker locker(&cacheMutex);
+        stopped = true;
+    }
+    prefetcher.waitForDone();
+    // Frames required on other threads are rendered outside the pool
+    QMutexLocker locker(&cacheMutex);
+    while (!rendering.isEmpty()) {
+        rendered.wait(&cacheMutex);
+    }
+}
+
+void LazyVideo::require(int frameNumber)
+{
+    QMutexLocker locker(&cacheMutex);
+    if (frameNumber > 0) {
+        // It may already be rendering, or queued to be, ahead
+        while (rendering.contains(frameNumber)) {
+            rendered.wait(&cacheMutex);
+        }
+        if (recent.contains(frameNumber)) {
+            touch(frameNumber);
+        } else if (!stopped) {
+            rendering.insert(frameNumber);
+            locker.unlock();
+            renderFrame(frameNumber);
+            locker.relock();
+        }
+    }
+    prefetchAfter(frameNumber);
+}
+
+// Pre: the frame is in rendering and cacheMutex is not locked
+void LazyVideo::renderFrame(int frameNumber)
+{
+    QMutexLocker locker(&cacheMutex);
+    if (!stopped) {
+        locker.unlock();
+        Mat image = ExportPlanner::render(ExportPlanner::STABILISED, source, frameNumber, interpolation);
+        locker.relock();
+        // Images are only replaced under cacheMutex, which getImageAt takes them under
+        Video::accessFrameAt(frameNumber)->setImage(image);
+        recent.prepend(frameNumber);
+        while (recent.size() > cacheSize) {
+            Video::accessFrameAt(recent.takeLast())->setImage(Mat());
+        }
+    }
+    rendering.remove(frameNumber);
+    rendered.wakeAll();
+}
+
+void LazyVideo::touch(int frameNumber)
+{
+    recent.move(recent.indexOf(frameNumber), 0);
+}
+
+// Pre: cacheMutex is locked
+void LazyVideo::prefetchAfter(int frameNumber)
+{
+    if (stopped) {
+        return;
+    }
+    int last = std::min(frameNumber + prefetch, getFrameCount()-1);
+    for (int f = frameNumber+1; f <= last; f++) {
+        if (!recent.contains(f) && !rendering.contains(f)) {
+            rendering.insert(f);
+            prefetcher.start(new PrefetchTask(this, f));
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef LAZYVIDEO_H
+#define LAZYVIDEO_H
+
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include "video.h"
+#include <opencv2/core/core.hpp>
+
+using namespace cv;
+
+/*
+ *
+ *  The new video, rendered from the original video a frame at a
+ *  time when it is first asked for. Only the most recently used
+ *  frames are kept, and the frames after the last one asked for
+ *  are rendered ahead on worker threads so playback does not wait.
+ *
+ */
+class LazyVideo : public Video
+{
+    Q_OBJECT
+
+public:
+    // The update transforms of the source are read as frames are rendered, so the
+    // source must outlive this video
+    LazyVideo(const Video* source, int interpolation, int cacheSize = 64, int prefetch = 16, QObject *parent = 0);
+
+    // Waits for the frames being rendered ahead
+    ~LazyVideo();
+
+    // Render the frame first if it is not cached. Frames are evicted on other
+    // threads, so images are read with getImageAt rather than through the frames
+    const Frame* getFrameAt(int frameNumber) const;
+    Frame* accessFrameAt(int frameNumber);
+    Mat getImageAt(int frameNumber) const;
+
+    // Renders and caches the frame if it is not cached yet, and starts rendering the
+    // frames after it. Safe to call from several threads at once
+    void require(int frameNumber);
+
+    // Waits for the frames being rendered and renders no more, for when the path
+    // of the source is about to change. Frames that are not cached show as the first
+    void stop();
+
+private:
+    const Video* source;
+    int interpolation;
+    int cacheSize;
+    int prefetch;
+
+    // Cached frames, the most recently used first, and the frames being rendered
+    // or queued to be. The first frame is always kept
+    QMutex cacheMutex;
+    QWaitCondition rendered;
+    QList<int> recent;
+    QSet<int> rendering;
+    bool stopped;
+
+    class PrefetchTask;
+    QThreadPool prefetcher;
+
+    void renderFrame(int frameNumber);
+    void touch(int frameNumber);
+    void prefetchAfter(int frameNumber);
+};
+
+#endif // LAZYVIDEO_H
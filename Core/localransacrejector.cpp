@@ -3,7 +3,7 @@
 #include <QDebug>
 
 LocalRANSACRejector::LocalRANSACRejector(QObject *parent) :
-    QObject(parent)
+    OutlierRejector(parent)
 {
     gridSize = 50;
     localRansacTolerance = 2;
@@ -12,7 +12,7 @@ LocalRANSACRejector::LocalRANSACRejector(QObject *parent) :
 }
 
 LocalRANSACRejector::LocalRANSACRejector(int gridSize, int localRansacTolerance, int newInliersThreshold, QObject *parent):
-    QObject(parent), gridSize(gridSize), localRansacTolerance(localRansacTolerance),newInliersThreshold(newInliersThreshold)
+    OutlierRejector(parent), gridSize(gridSize), localRansacTolerance(localRansacTolerance),newInliersThreshold(newInliersThreshold)
 {
     cellSize = Size(gridSize, gridSize);
 }
@@ -20,11 +20,13 @@ LocalRANSACRejector::LocalRANSACRejector(int gridSize, int localRansacTolerance,
 /*
  *  Implementation based on unstable unreleased source code of OpenCV3
  */
-void LocalRANSACRejector::process(Size frameSize, InputArray from, InputArray to, OutputArray mask) {
+void LocalRANSACRejector::process(Size frameSize, InputArray from, InputArray to, InputArray errors, OutputArray mask) const {
     int npoints = from.getMat().checkVector(2);
 
     const Point2f* from_ = from.getMat().ptr<Point2f>();
     const Point2f* to_ = to.getMat().ptr<Point2f>();
+    Mat errorsMat = errors.getMat();
+    const float* errors_ = errorsMat.empty() ? 0 : errorsMat.ptr<float>();
 
     mask.create(1, npoints, CV_8U);
     uchar* mask_ = mask.getMat().ptr<uchar>();
@@ -35,7 +37,7 @@ void LocalRANSACRejector::process(Size frameSize, InputArray from, InputArray to
     int cx, cy;
 
     // fill grid cells with our points
-    grid_.assign(ncells.area(), Cell());
+    std::vector<Cell> grid_(ncells.area());
 
     for (int i = 0; i < npoints; ++i)
     {
@@ -44,6 +46,13 @@ void LocalRANSACRejector::process(Size frameSize, InputArray from, InputArray to
         grid_[cy * ncells.width + cx].push_back(i);
     }
 
+    // PROSAC style: try the most reliable tracks first
+    if (errors_) {
+        for (size_t ci = 0; ci < grid_.size(); ci++) {
+            sortByError(grid_[ci], errors_);
+        }
+    }
+
     int niters = 30;
     int ninliers, ninliersMax;
     std::vector<int> inliers;
@@ -58,8 +67,10 @@ void LocalRANSACRejector::process(Size frameSize, InputArray from, InputArray to
         ninliersMax =0;
         dxBest = dyBest = 0.f;
         if (!cell.empty()) {
-            for (int iter = 0; iter < niters; iter++) {
-                idx = cell[static_cast<unsigned>(rand()) % cell.size()];
+            // Ordered hypotheses are never worth repeating
+            int cellIters = errors_ ? std::min(niters, (int) cell.size()) : niters;
+            for (int iter = 0; iter < cellIters; iter++) {
+                idx = errors_ ? cell[iter] : cell[static_cast<unsigned>(rand()) % cell.size()];
                 dx = to_[idx].x - from_[idx].x;
                 dy = to_[idx].y - from_[idx].y;
 
@@ -133,46 +144,6 @@ void LocalRANSACRejector::process(Size frameSize, InputArray from, InputArray to
 }
 
 
-void LocalRANSACRejector::execute(Video* video) {
-    // Divide each frame into grids
-//    for (int f=1; f<video->getFrameCount()-1; f++) {
-//        emit processProgressChanged(float(f)/video->getFrameCount()-2);
-//        Frame* frame = video->accessFrameAt(f);
-//        uint actualNum = frame->getDisplacements().size();
-//        uint numDisplacements = 0;
-//        for (int x=0; x < video->getWidth(); x+=gridSize)
-//        {
-//            for (int y=0; y < video->getHeight(); y+=gridSize)
-//            {
-//                vector<Displacement> displacements = frame->getDisplacements(x,y, gridSize);
-//                numDisplacements += displacements.size();
-//                if (!displacements.empty()) {
-//                    RansacModel model = localRansac(displacements);
-//                    frame->registerOutliers(model.getOutliers());
-//                }
-//            }
-//        }
-//        assert(actualNum == numDisplacements);
-//    }
-    for (int f = 1; f < video->getFrameCount()-1; f++) {
-        emit processProgressChanged(float(f)/video->getFrameCount()-2);
-        Frame* frame = video->accessFrameAt(f);
-        vector<Point2f> from = frame->getFrom();
-        vector<Point2f> to = frame->getTo();
-        vector<uchar> mask;
-        vector<Displacement> outliers;
-        process(frame->getSize(),from,to,mask);
-        for (uint i = 0; i < from.size(); i++) {
-            if (mask[i] != 1) {
-                Displacement d(from[i],to[i]);
-                outliers.push_back(d);
-            }
-        }
-        frame->registerOutliers(outliers);
-    }
-}
-
-
 Point2f fitTranslationModel(std::vector<Displacement> points) {
     // Option 1
     Point2f avgDisp = Point2f(0,0);
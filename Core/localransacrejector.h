@@ -3,19 +3,16 @@
 
 #include <QObject>
 #include "ransacmodel.h"
+#include "outlierrejector.h"
 #include "video.h"
 
-class LocalRANSACRejector : public QObject
+class LocalRANSACRejector : public OutlierRejector
 {
     Q_OBJECT
 public:
     explicit LocalRANSACRejector(QObject *parent = 0);
     LocalRANSACRejector(int gridSize, int localRansacTolerance, int newInliersThreshold, QObject *parent = 0);
-    void process(Size frameSize, InputArray from, InputArray to, OutputArray mask);
-    void execute(Video* video);
-    
-signals:
-    void processProgressChanged(float);
+    void process(Size frameSize, InputArray from, InputArray to, InputArray errors, OutputArray mask) const;
     
 public slots:
 
@@ -28,8 +25,6 @@ private:
     int iterations;
 
     Size cellSize;
-    typedef std::vector<int> Cell;
-    std::vector<Cell> grid_;
 
     RansacModel localRansac(const std::vector<Displacement>& points);
     
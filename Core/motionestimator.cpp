@@ -0,0 +1,363 @@
+#include "motionestimator.h"
+#include <QDebug>
+#include <algorithm>
+#include <math.h>
+
+namespace {
+    struct ErrorOrder {
+        const float* errors;
+        ErrorOrder(const float* errors):errors(errors) {}
+        bool operator()(int a, int b) const {return errors[a] < errors[b];}
+    };
+
+    // Reuses the storage of result if it is already 2x3 float
+    void toMat(const Matx23d& model, Mat& result) {
+        Mat(model).convertTo(result, DataType<float>::type);
+    }
+}
+
+MotionEstimator::MotionEstimator()
+{
+    method = ROBUST;
+    motionModel = AFFINE;
+    threshold = 0.5;
+    confidence = 0.99;
+    maxIterations = 200;
+    sampleSize = 3;
+    irlsIterations = 3;
+    residualThreshold = 1.5;
+    minFitRatio = 0.8;
+}
+
+void MotionEstimator::setMotionModel(MotionModel model)
+{
+    motionModel = model;
+    switch (motionModel) {
+    case TRANSLATION:
+        sampleSize = 1;
+        break;
+    case SIMILARITY:
+        sampleSize = 2;
+        break;
+    default:
+        sampleSize = 3;
+        break;
+    }
+}
+
+int MotionEstimator::getDOF() const
+{
+    switch (motionModel) {
+    case TRANSLATION:
+        return 2;
+    case SIMILARITY:
+        return 4;
+    default:
+        return 6;
+    }
+}
+
+void MotionEstimator::estimate(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& errors, Mat& affine, uint64 seed, int* ninliers) const
+{
+    assert(from.size() == to.size());
+    assert(errors.empty() || errors.size() == from.size());
+    int npoints = from.size();
+    Matx23d best(1, 0, 0,
+                 0, 1, 0);
+    if (npoints < sampleSize) {
+        qDebug() << "MotionEstimator::estimate - Too few points, assuming no motion";
+        if (ninliers) {
+            *ninliers = 0;
+        }
+        toMat(best, affine);
+        return;
+    }
+
+    if (method == LEAST_SQUARES) {
+        if (estimateLeastSquares(from, to, errors, best, ninliers)) {
+            toMat(best, affine);
+            return;
+        }
+        qDebug() << "MotionEstimator::estimate - Residuals too large, falling back to robust estimation";
+    }
+    estimateRobust(from, to, errors, best, seed, ninliers);
+    toMat(best, affine);
+}
+
+/*
+ *  Closed form weighted least squares, reweighted a few times with a
+ *  Huber function of the residuals (IRLS). Returns false if too few
+ *  points end up close to the fitted model.
+ */
+bool MotionEstimator::estimateLeastSquares(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& errors, Matx23d& model, int* ninliers) const
+{
+    int npoints = from.size();
+    vector<int> all(npoints);
+    vector<float> priors(npoints, 1.0f);
+    for (int i = 0; i < npoints; i++) {
+        all[i] = i;
+        if (!errors.empty()) {
+            priors[i] = 1.0f / (1.0f + errors[i]);
+        }
+    }
+    vector<float> weights = priors;
+    int count = 0;
+    for (int iter = 0; iter <= irlsIterations; iter++) {
+        if (!fitModel(from, to, weights, all, model)) {
+            return false;
+        }
+        // Huber weights, points further than the threshold count less
+        count = 0;
+        for (int i = 0; i < npoints; i++) {
+            const Point2f& p = from[i];
+            double dx = model(0,0)*p.x + model(0,1)*p.y + model(0,2) - to[i].x;
+            double dy = model(1,0)*p.x + model(1,1)*p.y + model(1,2) - to[i].y;
+            double residual = sqrt(dx*dx + dy*dy);
+            if (residual <= residualThreshold) {
+                weights[i] = priors[i];
+                count++;
+            } else {
+                weights[i] = priors[i] * residualThreshold / residual;
+            }
+        }
+    }
+    if (ninliers) {
+        *ninliers = count;
+    }
+    return count >= minFitRatio * npoints;
+}
+
+void MotionEstimator::estimateRobust(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& errors, Matx23d& best, uint64 seed, int* ninliers) const
+{
+    int npoints = from.size();
+
+    // Sort the points so that the most reliable tracks come first
+    vector<int> order(npoints);
+    for (int i = 0; i < npoints; i++) {
+        order[i] = i;
+    }
+    if (!errors.empty()) {
+        std::stable_sort(order.begin(), order.end(), ErrorOrder(&errors[0]));
+    }
+    vector<Point2f> src(npoints), dest(npoints);
+    vector<float> weights(npoints, 1.0f);
+    for (int i = 0; i < npoints; i++) {
+        src[i] = from[order[i]];
+        dest[i] = to[order[i]];
+        if (!errors.empty()) {
+            weights[i] = 1.0f / (1.0f + errors[order[i]]);
+        }
+    }
+
+    // PROSAC: hypotheses are drawn from the top n points, n growing with the iterations
+    int m = sampleSize;
+    double Tn = maxIterations;
+    for (int i = 0; i < m; i++) {
+        Tn *= double(m - i) / (npoints - i);
+    }
+    int TnPrime = 1;
+    int n = m;
+    int niters = maxIterations;
+    double bestScore = -1;
+    vector<int> sample(m);
+    Matx23d hypothesis;
+    RNG rng(seed);
+    for (int t = 1; t <= niters; t++) {
+        while (t > TnPrime && n < npoints) {
+            double TnNext = Tn * (n + 1) / (n + 1 - m);
+            TnPrime += cvCeil(TnNext - Tn);
+            Tn = TnNext;
+            n++;
+        }
+        drawSample(rng, n, t <= TnPrime, sample);
+        if (isDegenerate(src, sample) || !fitModel(src, dest, vector<float>(), sample, hypothesis)) {
+            continue;
+        }
+        int count;
+        double score = scoreInliers(src, dest, weights, hypothesis, &count);
+        if (score > bestScore) {
+            bestScore = score;
+            best = hypothesis;
+            double inlierRatio = double(count) / npoints;
+            if (inlierRatio >= 1) {
+                break;
+            }
+            double denominator = log(1 - pow(inlierRatio, m));
+            if (denominator < 0) {
+                niters = std::min(niters, std::max(cvCeil(log(1 - confidence) / denominator), t));
+            }
+        }
+    }
+
+    // Refine with a weighted least squares fit over the inliers
+    vector<int> inliers;
+    int count;
+    scoreInliers(src, dest, weights, best, &count, &inliers);
+    Matx23d refined;
+    if (count >= m && fitModel(src, dest, weights, inliers, refined)) {
+        best = refined;
+    }
+    if (ninliers) {
+        *ninliers = count;
+    }
+}
+
+// Weighted least squares fit of the motion model to the points in subset. Empty weights count as 1
+bool MotionEstimator::fitModel(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const
+{
+    switch (motionModel) {
+    case TRANSLATION:
+        return fitTranslation(from, to, weights, subset, model);
+    case SIMILARITY:
+        return fitSimilarity(from, to, weights, subset, model);
+    default:
+        return fitAffine(from, to, weights, subset, model);
+    }
+}
+
+// Weighted mean displacement
+bool MotionEstimator::fitTranslation(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const
+{
+    double sumW = 0, tx = 0, ty = 0;
+    for (size_t i = 0; i < subset.size(); i++) {
+        int idx = subset[i];
+        double w = weights.empty() ? 1 : weights[idx];
+        tx += w * (to[idx].x - from[idx].x);
+        ty += w * (to[idx].y - from[idx].y);
+        sumW += w;
+    }
+    if (sumW <= 0) {
+        return false;
+    }
+    model = Matx23d(1, 0, tx / sumW,
+                    0, 1, ty / sumW);
+    return true;
+}
+
+// Closed form weighted fit of x' = a*x - b*y + tx, y' = b*x + a*y + ty
+bool MotionEstimator::fitSimilarity(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const
+{
+    double sumW = 0;
+    Point2d fromMean(0, 0), toMean(0, 0);
+    for (size_t i = 0; i < subset.size(); i++) {
+        int idx = subset[i];
+        double w = weights.empty() ? 1 : weights[idx];
+        fromMean += Point2d(from[idx].x, from[idx].y) * w;
+        toMean += Point2d(to[idx].x, to[idx].y) * w;
+        sumW += w;
+    }
+    if (sumW <= 0) {
+        return false;
+    }
+    fromMean *= 1.0 / sumW;
+    toMean *= 1.0 / sumW;
+    double dot = 0, cross = 0, norm = 0;
+    for (size_t i = 0; i < subset.size(); i++) {
+        int idx = subset[i];
+        double w = weights.empty() ? 1 : weights[idx];
+        Point2d p = Point2d(from[idx].x, from[idx].y) - fromMean;
+        Point2d q = Point2d(to[idx].x, to[idx].y) - toMean;
+        dot += w * p.dot(q);
+        cross += w * p.cross(q);
+        norm += w * p.dot(p);
+    }
+    if (norm < 1e-9) {
+        return false;
+    }
+    double a = dot / norm;
+    double b = cross / norm;
+    model = Matx23d(a, -b, toMean.x - (a * fromMean.x - b * fromMean.y),
+                    b,  a, toMean.y - (b * fromMean.x + a * fromMean.y));
+    return true;
+}
+
+// Weighted least squares affine fit
+bool MotionEstimator::fitAffine(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const
+{
+    Matx33d AtA = Matx33d::zeros();
+    Matx32d Atb = Matx32d::zeros();
+    for (size_t i = 0; i < subset.size(); i++) {
+        int idx = subset[i];
+        double w = weights.empty() ? 1 : weights[idx];
+        double x = from[idx].x;
+        double y = from[idx].y;
+        AtA(0,0) += w*x*x; AtA(0,1) += w*x*y; AtA(0,2) += w*x;
+        AtA(1,1) += w*y*y; AtA(1,2) += w*y;
+        AtA(2,2) += w;
+        Atb(0,0) += w*x*to[idx].x; Atb(0,1) += w*x*to[idx].y;
+        Atb(1,0) += w*y*to[idx].x; Atb(1,1) += w*y*to[idx].y;
+        Atb(2,0) += w*to[idx].x;   Atb(2,1) += w*to[idx].y;
+    }
+    AtA(1,0) = AtA(0,1);
+    AtA(2,0) = AtA(0,2);
+    AtA(2,1) = AtA(1,2);
+    Matx32d solution;
+    if (!cv::solve(AtA, Atb, solution, DECOMP_CHOLESKY)) {
+        return false;
+    }
+    model = Matx23d(solution(0,0), solution(1,0), solution(2,0),
+                    solution(0,1), solution(1,1), solution(2,1));
+    return true;
+}
+
+// Returns the summed weight of the inliers of model
+double MotionEstimator::scoreInliers(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const Matx23d& model, int* count, vector<int>* inliers) const
+{
+    double threshold2 = threshold * threshold;
+    double score = 0;
+    int ninliers = 0;
+    for (size_t i = 0; i < from.size(); i++) {
+        const Point2f& p = from[i];
+        double dx = model(0,0)*p.x + model(0,1)*p.y + model(0,2) - to[i].x;
+        double dy = model(1,0)*p.x + model(1,1)*p.y + model(1,2) - to[i].y;
+        if (dx*dx + dy*dy < threshold2) {
+            score += weights[i];
+            ninliers++;
+            if (inliers) {
+                inliers->push_back(i);
+            }
+        }
+    }
+    if (count) {
+        *count = ninliers;
+    }
+    return score;
+}
+
+bool MotionEstimator::isDegenerate(const vector<Point2f>& from, const vector<int>& sample) const
+{
+    if (sample.size() < 2) {
+        return false;
+    }
+    // Coincident points do not define a similarity
+    if (sample.size() == 2) {
+        Point2f u = from[sample[1]] - from[sample[0]];
+        return u.dot(u) < 1;
+    }
+    // Collinear points do not define an affine transform
+    Point2f u = from[sample[1]] - from[sample[0]];
+    Point2f v = from[sample[2]] - from[sample[0]];
+    return fabs(u.cross(v)) < 1;
+}
+
+// Draws sample.size() distinct indices from the top n points, including n-1 if asked
+void MotionEstimator::drawSample(RNG& rng, int n, bool includeLast, vector<int>& sample) const
+{
+    int k = 0;
+    if (includeLast) {
+        sample[k++] = n - 1;
+    }
+    int range = includeLast ? n - 1 : n;
+    while (k < (int) sample.size()) {
+        int idx = rng.uniform(0, range);
+        bool repeated = false;
+        for (int j = 0; j < k; j++) {
+            if (sample[j] == idx) {
+                repeated = true;
+            }
+        }
+        if (!repeated) {
+            sample[k++] = idx;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef MOTIONESTIMATOR_H
+#define MOTIONESTIMATOR_H
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+/*
+ *
+ *  Estimates the global motion between two frames from
+ *  the inlying displacements. Hypotheses are drawn PROSAC-style,
+ *  starting from the tracks with the lowest optical flow error,
+ *  and the final fit is weighted by the same error.
+ *
+ */
+class MotionEstimator
+{
+public:
+    // ROBUST runs RANSAC over the points. LEAST_SQUARES assumes the points
+    // were already filtered by the outlier rejector and fits them directly,
+    // only falling back to ROBUST if the fit leaves large residuals.
+    enum Method {ROBUST, LEAST_SQUARES};
+
+    // Each model has its own minimal solver: 1 point for a translation,
+    // 2 points for a similarity and 3 points for a full affine transform
+    enum MotionModel {TRANSLATION, SIMILARITY, AFFINE};
+
+    MotionEstimator();
+
+    // Writes the 2x3 affine transform (CV_32F) mapping from onto to into affine.
+    // errors[i] is the tracking error of point i, it may be left empty.
+    // Sampling is seeded with seed so results do not depend on thread scheduling
+    void estimate(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& errors, Mat& affine, uint64 seed = 0, int* ninliers = 0) const;
+
+    void setThreshold(double threshold) {this->threshold = threshold;}
+    void setMaxIterations(int maxIterations) {this->maxIterations = maxIterations;}
+    void setMethod(Method method) {this->method = method;}
+    Method getMethod() const {return method;}
+    void setMotionModel(MotionModel model);
+    MotionModel getMotionModel() const {return motionModel;}
+    int getDOF() const;
+
+private:
+    Method method;
+    MotionModel motionModel;
+    double threshold;   // Inlier distance in pixels
+    double confidence;
+    int maxIterations;
+    int sampleSize;
+
+    // Least squares settings
+    int irlsIterations;
+    double residualThreshold; // Residual in pixels above which a point is badly fit
+    double minFitRatio;       // Fraction of points that must be well fit to accept the fit
+
+    void estimateRobust(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& errors, Matx23d& model, uint64 seed, int* ninliers) const;
+    bool estimateLeastSquares(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& errors, Matx23d& model, int* ninliers) const;
+
+    bool fitModel(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const;
+    bool fitTranslation(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const;
+    bool fitSimilarity(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const;
+    bool fitAffine(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const vector<int>& subset, Matx23d& model) const;
+    double scoreInliers(const vector<Point2f>& from, const vector<Point2f>& to, const vector<float>& weights, const Matx23d& model, int* count, vector<int>* inliers = 0) const;
+    bool isDegenerate(const vector<Point2f>& from, const vector<int>& sample) const;
+    void drawSample(RNG& rng, int n, bool includeLast, vector<int>& sample) const;
+
+};
+
+#endif // MOTIONESTIMATOR_H
@@ -0,0 +1,147 @@
+#include "onlinestabiliser.h"
+#include "frame.h"
+#include <QDebug>
+#include <QThread>
+
+OnlineStabiliser::OnlineStabiliser(VideoProcessor* processor, QObject *parent) :
+    QObject(parent), processor(processor)
+{
+    sink = 0;
+    fromDevice = false;
+    fps = 25;
+    fourCC = CV_FOURCC('M','J','P','G');
+    latency = 15;
+    horizon = 0;
+    stopped = false;
+    buffer = 0;
+    anchorEmitted = false;
+    emittedFrames = 0;
+    totalLatency = 0;
+    maxLatency = 0;
+}
+
+void OnlineStabiliser::setLatency(int frames)
+{
+    latency = std::max(frames, 0);
+}
+
+void OnlineStabiliser::setHorizon(int frames)
+{
+    horizon = frames > 0 ? std::max(frames, 2) : 0;
+}
+
+bool OnlineStabiliser::open(const QString& source)
+{
+    int device = source.toInt(&fromDevice);
+    bool opened = fromDevice ? capture.open(device) : capture.open(source.toStdString());
+    if (!opened) {
+        qDebug() << "OnlineStabiliser::open - Could not open" << source;
+        return false;
+    }
+    // Capture devices do not always report these
+    double sourceFps = capture.get(CV_CAP_PROP_FPS);
+    fps = sourceFps > 0 ? sourceFps : 25;
+    int sourceFourCC = capture.get(CV_CAP_PROP_FOURCC);
+    fourCC = sourceFourCC != 0 ? sourceFourCC : CV_FOURCC('M','J','P','G');
+    return true;
+}
+
+double OnlineStabiliser::getMeanLatency() const
+{
+    return emittedFrames > 0 ? totalLatency / emittedFrames : 0;
+}
+
+void OnlineStabiliser::run()
+{
+    qDebug() << "OnlineStabiliser::run - Started with a latency of" << latency << "frames at" << fps << "fps";
+    processor->discardPathModels();
+    delete buffer;
+    buffer = new Video(latency+3, fps, this);
+    anchorEmitted = false;
+    arrivals.clear();
+    emittedFrames = 0;
+    totalLatency = 0;
+    maxLatency = 0;
+    stopped = false;
+
+    clock.start();
+    Mat image;
+    for (int f = 0; !stopped; f++) {
+        // Files are replayed at their frame rate. A frame read late, because
+        // processing fell behind, still counts from when it was due
+        qint64 arrival = qint64(f * 1000 / fps);
+        if (!fromDevice) {
+            qint64 wait = arrival - clock.elapsed();
+            if (wait > 0) {
+                QThread::msleep(wait);
+            }
+        }
+        if (!capture.read(image)) {
+            break;
+        }
+        if (fromDevice) {
+            arrival = clock.elapsed();
+        }
+        addFrame(image, arrival);
+        emitFrames(false);
+        if (sink != 0 && !sink->isOpened()) {
+            qWarning() << "OnlineStabiliser::run - Output failed, stopping";
+            return;
+        }
+    }
+    // The last frames are emitted with whatever look-ahead is left
+    emitFrames(true);
+    qDebug() << "OnlineStabiliser::run - Finished after" << emittedFrames << "frames";
+}
+
+void OnlineStabiliser::addFrame(const Mat& image, qint64 arrival)
+{
+    arrivals.enqueue(arrival);
+    if (buffer->getFrameCount() == 0) {
+        buffer->appendFrame(new Frame(image, buffer));
+        buffer->appendFrame(new Frame(image, buffer));
+        buffer->setCropBox(cropBox.x, cropBox.y, cropBox.width, cropBox.height);
+        buffer->accessFrameAt(1)->setUpdateTransform(Mat::eye(2, 3, DataType<float>::type));
+        edgeMask = VideoProcessor::buildEdgeMask(image.size());
+        return;
+    }
+    buffer->appendFrame(new Frame(image, buffer));
+    processor->analyseFramePair(buffer, buffer->getFrameCount()-1, 0, edgeMask, false);
+}
+
+// Emits the waiting frames in order, each once latency frames have arrived after it
+void OnlineStabiliser::emitFrames(bool flush)
+{
+    while (!arrivals.isEmpty()) {
+        int next = anchorEmitted ? 2 : 1;
+        int newest = buffer->getFrameCount()-1;
+        if (newest - next < latency && !flush) {
+            return;
+        }
+        if (!anchorEmitted) {
+            // The first frame starts the path, so it is a plain crop
+            emitFrame(Mat(buffer->getFrameAt(1)->getOriginalData(), cropBox).clone());
+            anchorEmitted = true;
+            continue;
+        }
+        int count = horizon > 0 ? std::min(newest, horizon) : newest;
+        processor->solvePathHorizon(buffer, 1, count, buffer->getFrameAt(1)->getUpdateTransform().clone());
+        const Frame* frame = buffer->getFrameAt(2);
+        emitFrame(VideoProcessor::cropImage(frame->getOriginalData(), frame->getUpdateTransform(), cropBox, processor->getInterpolation()));
+        // The emitted frame becomes the anchor of the next horizon
+        buffer->removeFirstFrame();
+    }
+}
+
+void OnlineStabiliser::emitFrame(const Mat& image)
+{
+    double frameLatency = clock.elapsed() - arrivals.dequeue();
+    totalLatency += frameLatency;
+    maxLatency = std::max(maxLatency, frameLatency);
+    qDebug() << "OnlineStabiliser::emitFrame - Frame" << emittedFrames << "after" << frameLatency << "ms";
+    if (sink != 0) {
+        sink->write(image);
+    }
+    emit frameStabilised(image, emittedFrames);
+    emittedFrames++;
+}
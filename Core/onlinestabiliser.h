@@ -0,0 +1,95 @@
+#ifndef ONLINESTABILISER_H
+#define ONLINESTABILISER_H
+
+#include <QObject>
+#include <QQueue>
+#include <QElapsedTimer>
+#include "video.h"
+#include "videoprocessor.h"
+#include "framesink.h"
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+using namespace cv;
+
+/*
+ *
+ *  Stabilises frames as they arrive from a capture device or file.
+ *  The motion of each new frame pair is estimated straight away and
+ *  a frame is emitted once latency more frames have arrived. Its
+ *  update transform comes from the L1 path over a horizon starting
+ *  at the last emitted frame, which the path is anchored to.
+ *
+ */
+class OnlineStabiliser : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Analysis, path and interpolation settings are taken from the processor
+    explicit OnlineStabiliser(VideoProcessor* processor, QObject *parent = 0);
+
+    // Frames of look-ahead before a frame is emitted
+    void setLatency(int frames);
+
+    // Most frames optimised at once, the last emitted frame included.
+    // 0 optimises over the whole look-ahead
+    void setHorizon(int frames);
+
+    void setCropBox(const Rect& cropBox) {this->cropBox = cropBox;}
+
+    // Opens a file, or a capture device given by its index. Files are
+    // read at their native frame rate, as a camera would deliver them
+    bool open(const QString& source);
+    double getFps() const {return fps;}
+    int getFourCC() const {return fourCC;}
+
+    // Writes the stabilised frames to the sink as well
+    void setSink(FrameSink* sink) {this->sink = sink;}
+
+    // End to end latency of the emitted frames in ms, from when a frame was
+    // due from the source to when its stabilised crop was emitted
+    int getEmittedFrames() const {return emittedFrames;}
+    double getMeanLatency() const;
+    double getMaxLatency() const {return maxLatency;}
+
+signals:
+    void frameStabilised(const Mat& image, int frameNumber);
+
+public slots:
+    // Reads the source until it ends or stop is called
+    void run();
+    void stop() {stopped = true;}
+
+private:
+    VideoProcessor* processor;
+    VideoCapture capture;
+    FrameSink* sink;
+    bool fromDevice;
+    double fps;
+    int fourCC;
+    int latency;
+    int horizon;
+    Rect cropBox;
+    volatile bool stopped;
+
+    // The frame before the last emitted one, the last emitted frame and the
+    // frames waiting to be emitted. The path models never start at frame 0,
+    // so the first frame read is put in twice
+    Video* buffer;
+    bool anchorEmitted;
+    Mat edgeMask;
+
+    // When each waiting frame was due from the source
+    QElapsedTimer clock;
+    QQueue<qint64> arrivals;
+    int emittedFrames;
+    double totalLatency;
+    double maxLatency;
+
+    void addFrame(const Mat& image, qint64 arrival);
+    void emitFrames(bool flush);
+    void emitFrame(const Mat& image);
+};
+
+#endif // ONLINESTABILISER_H
@@ -0,0 +1,46 @@
+#include "outlierrejector.h"
+#include "frame.h"
+#include "displacement.h"
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+    struct ErrorOrder {
+        const float* errors;
+        ErrorOrder(const float* errors):errors(errors) {}
+        bool operator()(int a, int b) const {return errors[a] < errors[b];}
+    };
+}
+
+OutlierRejector::OutlierRejector(QObject *parent) :
+    QObject(parent)
+{
+}
+
+OutlierRejector::~OutlierRejector()
+{
+}
+
+void OutlierRejector::execute(Video* video) {
+    for (int f = 1; f < video->getFrameCount()-1; f++) {
+        emit processProgressChanged(float(f)/video->getFrameCount()-2);
+        Frame* frame = video->accessFrameAt(f);
+        vector<Point2f> from = frame->getFrom();
+        vector<Point2f> to = frame->getTo();
+        vector<float> errors = frame->getErrors();
+        vector<uchar> mask;
+        vector<Displacement> outliers;
+        process(frame->getSize(),from,to,errors,mask);
+        for (uint i = 0; i < from.size(); i++) {
+            if (mask[i] != 1) {
+                Displacement d(from[i],to[i]);
+                outliers.push_back(d);
+            }
+        }
+        frame->registerOutliers(outliers);
+    }
+}
+
+void OutlierRejector::sortByError(Cell& cell, const float* errors) {
+    std::stable_sort(cell.begin(), cell.end(), ErrorOrder(errors));
+}
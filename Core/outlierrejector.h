@@ -0,0 +1,39 @@
+#ifndef OUTLIERREJECTOR_H
+#define OUTLIERREJECTOR_H
+
+#include <QObject>
+#include "video.h"
+
+/*
+ *
+ *  Base class for the local outlier rejection strategies.
+ *  Subclasses decide which tracked displacements in a frame
+ *  are inliers, execute() applies that to every frame of a video.
+ *
+ */
+class OutlierRejector : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OutlierRejector(QObject *parent = 0);
+    virtual ~OutlierRejector();
+
+    // Sets mask[i] to 1 if the displacement from[i] -> to[i] is an inlier.
+    // If given, errors[i] is the tracking error of that displacement and
+    // hypotheses are drawn from the most reliable tracks first.
+    // Must be safe to call from several threads at once
+    virtual void process(Size frameSize, InputArray from, InputArray to, InputArray errors, OutputArray mask) const = 0;
+    void execute(Video* video);
+
+signals:
+    void processProgressChanged(float);
+
+protected:
+    typedef std::vector<int> Cell;
+
+    // Orders the points of a cell by increasing tracking error
+    static void sortByError(Cell& cell, const float* errors);
+
+};
+
+#endif // OUTLIERREJECTOR_H
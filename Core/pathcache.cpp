@@ -0,0 +1,153 @@
+#include "pathcache.h"
+#include "frame.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+namespace {
+    const quint32 magic = 0x4c31504d; // "L1PM"
+    const quint32 version = 1;
+
+    void addInt(QCryptographicHash& hash, int value) {
+        qint32 v = value;
+        hash.addData(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void addFloat(QCryptographicHash& hash, float value) {
+        hash.addData(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+
+PathCache::PathCache()
+{
+}
+
+void PathCache::setDirectory(const QString& directory)
+{
+    this->directory = directory;
+    if (isEnabled()) {
+        QDir().mkpath(directory);
+    }
+}
+
+QByteArray PathCache::shapeKey(Video* video, int dof, bool salient)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    addInt(hash, video->getFrameCount());
+    addInt(hash, dof);
+    addInt(hash, salient);
+    return hash.result().toHex();
+}
+
+QByteArray PathCache::problemKey(Video* video, int dof, bool salient, bool centered)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(shapeKey(video, dof, salient));
+    addInt(hash, salient && centered);
+    addInt(hash, video->getWidth());
+    addInt(hash, video->getHeight());
+    Rect cropBox = video->getCropBox();
+    addInt(hash, cropBox.x);
+    addInt(hash, cropBox.y);
+    addInt(hash, cropBox.width);
+    addInt(hash, cropBox.height);
+    // Frame by frame, row by row, as the transforms are stored
+    Mat affines = video->getAffineTransforms(1, video->getFrameCount()-1);
+    for (int r = 0; r < affines.rows; r++) {
+        for (int c = 0; c < 3; c++) {
+            addFloat(hash, affines.at<float>(r,c));
+        }
+    }
+    if (salient) {
+        for (int f = 0; f < video->getFrameCount()-1; f++) {
+            Point2f* feature = video->accessFrameAt(f)->getFeature();
+            addFloat(hash, feature->x);
+            addFloat(hash, feature->y);
+        }
+    }
+    return hash.result().toHex();
+}
+
+bool PathCache::loadSolution(const QByteArray& key, vector<double>& columns) const
+{
+    if (!isEnabled()) {
+        return false;
+    }
+    QFile file(path(key, "solution"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 fileMagic, fileVersion, count;
+    in >> fileMagic >> fileVersion >> count;
+    // A truncated or corrupt count would otherwise be allocated as it is
+    if (fileMagic != magic || fileVersion != version || count > (file.size() - file.pos()) / sizeof(double)) {
+        qDebug() << "PathCache::loadSolution - Ignoring" << file.fileName();
+        return false;
+    }
+    columns.resize(count);
+    for (quint32 i = 0; i < count; i++) {
+        in >> columns[i];
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool PathCache::loadBasis(const QByteArray& shapeKey, vector<unsigned char>& basis) const
+{
+    if (!isEnabled()) {
+        return false;
+    }
+    QFile file(path(shapeKey, "basis"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 fileMagic, fileVersion, count;
+    in >> fileMagic >> fileVersion >> count;
+    if (fileMagic != magic || fileVersion != version || count > file.size() - file.pos()) {
+        qDebug() << "PathCache::loadBasis - Ignoring" << file.fileName();
+        return false;
+    }
+    basis.resize(count);
+    for (quint32 i = 0; i < count; i++) {
+        quint8 status;
+        in >> status;
+        basis[i] = status;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+void PathCache::save(const QByteArray& key, const QByteArray& shapeKey, const vector<double>& columns, const vector<unsigned char>& basis) const
+{
+    if (!isEnabled()) {
+        return;
+    }
+    QFile solutionFile(path(key, "solution"));
+    if (solutionFile.open(QIODevice::WriteOnly)) {
+        QDataStream out(&solutionFile);
+        out << magic << version << quint32(columns.size());
+        for (uint i = 0; i < columns.size(); i++) {
+            out << columns[i];
+        }
+    } else {
+        qDebug() << "PathCache::save - Could not write" << solutionFile.fileName();
+    }
+    if (basis.empty()) {
+        return;
+    }
+    QFile basisFile(path(shapeKey, "basis"));
+    if (basisFile.open(QIODevice::WriteOnly)) {
+        QDataStream out(&basisFile);
+        out << magic << version << quint32(basis.size());
+        for (uint i = 0; i < basis.size(); i++) {
+            out << quint8(basis[i]);
+        }
+    }
+}
+
+QString PathCache::path(const QByteArray& key, const QString& suffix) const
+{
+    return QDir(directory).filePath(QString::fromLatin1(key) + "." + suffix);
+}
@@ -0,0 +1,44 @@
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <vector>
+#include "video.h"
+
+using namespace std;
+
+/*
+ *
+ *  On-disk cache of solved camera path LPs.
+ *  Solutions are stored under a hash of everything that defines the
+ *  problem (frame motions, crop box, DOF and salient inputs). The last
+ *  basis of every problem shape is also kept, so a problem that only
+ *  differs in its data can warm start from it.
+ *
+ */
+class PathCache
+{
+public:
+    PathCache();
+
+    // An empty directory disables the cache
+    void setDirectory(const QString& directory);
+    bool isEnabled() const {return !directory.isEmpty();}
+
+    static QByteArray problemKey(Video* video, int dof, bool salient, bool centered);
+    // Problems with the same shape have the same number of rows and columns
+    static QByteArray shapeKey(Video* video, int dof, bool salient);
+
+    bool loadSolution(const QByteArray& key, vector<double>& columns) const;
+    bool loadBasis(const QByteArray& shapeKey, vector<unsigned char>& basis) const;
+    void save(const QByteArray& key, const QByteArray& shapeKey, const vector<double>& columns, const vector<unsigned char>& basis) const;
+
+private:
+    QString directory;
+
+    QString path(const QByteArray& key, const QString& suffix) const;
+
+};
+
+#endif // PATHCACHE_H
@@ -1,6 +1,7 @@
 #ifndef TOOLS_H
 #define TOOLS_H
 #include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
 #include "video.h"
 #include "frame.h"
 #include "evaluator.h"
@@ -12,9 +13,48 @@ class Tools
 public:
     Tools();
     static float eucDistance(Point2f a, Point2f b);
-    static Point2f applyAffineTransformation(Mat affine, Point2f src);
-    static RotatedRect transformRectangle(const Mat& affine, const Rect& origRect);
-    static Mat getCroppedImage(const Mat& image, const RotatedRect& rect);
+
+    // Affine transforms as 2x3 matrices [A|t], mapping p to A*p + t. These
+    // work on the stack, so they are cheap enough to call per point
+    static Point2f applyAffineTransformation(const Matx23f& affine, const Point2f& src) {
+        return Point2f(affine(0,0)*src.x + affine(0,1)*src.y + affine(0,2),
+                       affine(1,0)*src.x + affine(1,1)*src.y + affine(1,2));
+    }
+
+    // The transform applying inner and then outer
+    static Matx23f composeAffine(const Matx23f& outer, const Matx23f& inner) {
+        return Matx23f(outer(0,0)*inner(0,0) + outer(0,1)*inner(1,0),
+                       outer(0,0)*inner(0,1) + outer(0,1)*inner(1,1),
+                       outer(0,0)*inner(0,2) + outer(0,1)*inner(1,2) + outer(0,2),
+                       outer(1,0)*inner(0,0) + outer(1,1)*inner(1,0),
+                       outer(1,0)*inner(0,1) + outer(1,1)*inner(1,1),
+                       outer(1,0)*inner(0,2) + outer(1,1)*inner(1,2) + outer(1,2));
+    }
+
+    // Zero for a singular transform, like cv::invertAffineTransform
+    static Matx23f invertAffine(const Matx23f& affine) {
+        float det = affine(0,0)*affine(1,1) - affine(0,1)*affine(1,0);
+        det = det != 0 ? 1/det : 0;
+        float a = affine(1,1)*det, b = -affine(0,1)*det;
+        float d = -affine(1,0)*det, e = affine(0,0)*det;
+        return Matx23f(a, b, -a*affine(0,2) - b*affine(1,2),
+                       d, e, -d*affine(0,2) - e*affine(1,2));
+    }
+
+    static Matx23f translationAffine(float x, float y) {
+        return Matx23f(1, 0, x, 0, 1, y);
+    }
+
+    static RotatedRect transformRectangle(const Matx23f& affine, const Rect& origRect) {
+        Point2f verts[4] = {
+            applyAffineTransformation(affine, Point2f(origRect.x, origRect.y)),
+            applyAffineTransformation(affine, Point2f(origRect.x, origRect.y+origRect.height)),
+            applyAffineTransformation(affine, Point2f(origRect.x+origRect.width, origRect.y)),
+            applyAffineTransformation(affine, Point2f(origRect.x+origRect.width, origRect.y+origRect.height))
+        };
+        return minAreaRect(Mat(4, 1, DataType<Point2f>::type, verts));
+    }
+
     static Point2f QPointToPoint2f(QPoint p);
 
     // Move coordinates to start from 0,0
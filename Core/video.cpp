@@ -6,9 +6,10 @@
 
 using namespace cv;
 
-Video::Video(int frameCount, int fps, QObject *parent):QObject(parent),mutex(QMutex::Recursive),originalFps(fps)
+Video::Video(int frameCount, double fps, QObject *parent):QObject(parent),mutex(QMutex::Recursive),originalFps(fps)
 {
     frames.reserve(frameCount);
+    reserveTransforms(std::max(frameCount, 1));
 }
 
 Video::~Video()
@@ -34,20 +35,49 @@ void Video::initCropBox()
     cropBox = Rect_<int>(x,y,width,width);
 }
 
+void Video::reserveTransforms(int frameCount)
+{
+    affineTransforms = Mat::zeros(2*frameCount, 3, DataType<float>::type);
+    updateTransforms = Mat::zeros(2*frameCount, 3, DataType<float>::type);
+}
+
+// The frame's transforms are copied into its rows first
+void Video::bindTransforms(int frameNumber)
+{
+    frames[frameNumber]->bindTransforms(affineTransforms.rowRange(2*frameNumber, 2*frameNumber+2),
+                                        updateTransforms.rowRange(2*frameNumber, 2*frameNumber+2));
+}
+
 void Video::appendFrame(Frame* frame)
 {
     QMutexLocker locker(&mutex);
     frames.append(frame);
+    if (2*frames.size() > affineTransforms.rows) {
+        reserveTransforms(2*frames.size());
+        for (int f = 0; f < frames.size()-1; f++) {
+            bindTransforms(f);
+        }
+    }
+    bindTransforms(frames.size()-1);
     if (frames.size() == 1) {
         initCropBox();
     }
 }
 
-const Mat& Video::getImageAt(int frameNumber) const
+void Video::removeFirstFrame()
+{
+    QMutexLocker locker(&mutex);
+    delete frames.takeFirst();
+    // In order, so each frame only overwrites the rows of one already moved
+    for (int f = 0; f < frames.size(); f++) {
+        bindTransforms(f);
+    }
+}
+
+Mat Video::getImageAt(int frameNumber) const
 {
     QMutexLocker locker(&mutex);
-    const Frame& f = frames.at(frameNumber);
-    const Mat& img = f.getOriginalData();
+    const Mat& img = frames.at(frameNumber)->getOriginalData();
     if (!img.data)
     {
         qDebug() << "No image data found in frame " << frameNumber;
@@ -73,16 +103,18 @@ int Video::getFrameCount() const
     return frames.size();
 }
 
-//TODO This shouldnt be here
-vector<Mat> Video::getAffineTransforms() const
+Mat Video::getAffineTransforms(int first, int count) const
 {
     QMutexLocker locker(&mutex);
-    vector<Mat> transforms;
-    for (int i = 1; i < frames.size(); i++) {
-        const Mat& transform = frames[i]->getAffineTransform();
-        transforms.push_back(transform);
-    }
-    return transforms;
+    assert(first >= 0 && first+count <= frames.size());
+    return affineTransforms.rowRange(2*first, 2*(first+count));
+}
+
+Mat Video::getUpdateTransforms(int first, int count) const
+{
+    QMutexLocker locker(&mutex);
+    assert(first >= 0 && first+count <= frames.size());
+    return updateTransforms.rowRange(2*first, 2*(first+count));
 }
 
 Size Video::getSize() const {
@@ -23,23 +23,33 @@ class Video : public QObject
     Q_OBJECT
 
 public:
-    Video(int frameCount, int fps = 27, QObject *parent = 0);
+    Video(int frameCount, double fps = 27, QObject *parent = 0);
     ~Video();
 
     QList<Frame>& getFrames();
     void appendFrame(Frame* frame);
 
-    const Frame* getFrameAt(int frameNumber) const;
-    Frame* accessFrameAt(int frameNumber);
-    const Mat& getImageAt(int frameNumber) const;
+    // Deletes the oldest frame, for videos used as a buffer of the latest frames
+    void removeFirstFrame();
+
+    // Lazily rendered videos render the frame first
+    virtual const Frame* getFrameAt(int frameNumber) const;
+    virtual Frame* accessFrameAt(int frameNumber);
+    // Shares the image rather than referencing it, as lazily rendered frames
+    // may be released while it is used
+    virtual Mat getImageAt(int frameNumber) const;
     int getFrameCount() const;
 
     Size getSize() const;
     int getWidth() const;
     int getHeight() const;
-    int getOrigFps() const {return originalFps;}
+    double getOrigFps() const {return originalFps;}
 
-    vector<Mat> getAffineTransforms() const;
+    // Transforms of frames [first, first+count) as one 2*count x 3 float Mat, frame
+    // first+i in rows 2i and 2i+1. The transforms of every frame are stored together
+    // and the frames' own transforms are headers into them, so nothing is copied
+    Mat getAffineTransforms(int first, int count) const;
+    Mat getUpdateTransforms(int first, int count) const;
 
     void setCropBox(int x, int y, int width, int height);
     const Rect_<int>& getCropBox() const {return cropBox;}
@@ -54,9 +64,16 @@ private:
 
     QString videoName;
     QList<Frame*> frames;
-    int originalFps;
+    double originalFps;
     Rect_<int> cropBox; // The starting crop box
 
+    // Frame f's transforms are rows 2f and 2f+1. Room is kept for more frames
+    // than there are, and the frames are moved over when it runs out
+    Mat affineTransforms;
+    Mat updateTransforms;
+    void reserveTransforms(int frameCount);
+    void bindTransforms(int frameNumber);
+
     void initCropBox();
 };
 
@@ -13,31 +13,107 @@
 #include <coin/OsiSolverInterface.hpp>
 #include <coin/OsiClpSolverInterface.hpp>
 #include <QList>
+#include <QElapsedTimer>
 #include "frame.h"
 #include "video.h"
 #include "displacement.h"
 #include "ransacmodel.h"
+#include "localransacrejector.h"
+#include "hierarchicalransacrejector.h"
 #include "tools.h"
 #include "l1model.h"
 #include "l1salientmodel.h"
+#include "l1bandedmodel.h"
+#include "exportplanner.h"
 #include <stdio.h>
+#include <math.h>
 #include <iostream>
 #include <QDebug>
 #include <QObject>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThreadPool>
+#include <QSemaphore>
 #include <vector>
 #include <engine.h>
 
 using namespace std;
 
+namespace {
+    // Estimates the global motion of one frame, seeded by the frame number
+    class MotionModelTask : public QRunnable
+    {
+    public:
+        MotionModelTask(const MotionEstimator& estimator, Frame* frame, int frameNumber, QAtomicInt& completed):
+            estimator(estimator), frame(frame), frameNumber(frameNumber), completed(completed) {}
+
+        void run() {
+            vector<Point2f> srcPoints, destPoints;
+            vector<float> errors;
+            frame->getInliers(srcPoints,destPoints,errors);
+            // Estimated outside the frame's lock, then stored under it
+            Matx23f affine;
+            Mat result(affine, false);
+            estimator.estimate(srcPoints, destPoints, errors, result, frameNumber);
+            frame->setAffineTransform(result);
+            completed.ref();
+        }
+
+    private:
+        const MotionEstimator& estimator;
+        Frame* frame;
+        int frameNumber;
+        QAtomicInt& completed;
+    };
+}
+
+namespace {
+    // Runs the whole analysis of one frame pair, then frees its slot in the queue
+    class FramePairTask : public QRunnable
+    {
+    public:
+        FramePairTask(VideoProcessor* vp, Video* video, int frameNumber, int radius, const Mat& edgeMask, bool keepDiagnostics, QSemaphore& available, QAtomicInt& completed):
+            vp(vp), video(video), frameNumber(frameNumber), radius(radius), edgeMask(edgeMask), keepDiagnostics(keepDiagnostics), available(available), completed(completed) {}
+
+        void run() {
+            vp->analyseFramePair(video, frameNumber, radius, edgeMask, keepDiagnostics);
+            completed.ref();
+            available.release();
+        }
+
+    private:
+        VideoProcessor* vp;
+        Video* video;
+        int frameNumber;
+        int radius;
+        const Mat& edgeMask;
+        bool keepDiagnostics;
+        QSemaphore& available;
+        QAtomicInt& completed;
+    };
+}
+
 VideoProcessor::VideoProcessor(QObject *parent):QObject(parent),mutex(QMutex::Recursive) {
-    QObject::connect(&outlierRejector, SIGNAL(processProgressChanged(float)), this, SIGNAL(processProgressChanged(float)));
+    outlierRejector = 0;
+    pathWindowSize = 0;
+    pathWindowOverlap = 0;
+    bandedPathSolver = false;
+    solverStrategy = L1Model::DUAL;
+    solverScaling = 1;
+    solverPresolve = true;
+    bandedTolerance = 1e-3;
+    interpolation = INTER_CUBIC;
+    pathModel = 0;
+    salientPathModel = 0;
+    pathModelVideo = 0;
+    pathModelDOF = 0;
+    setOutlierRejector(new LocalRANSACRejector(this));
     //featureDetector = FeatureDetector::create("GFTT");
     featureDetector = Ptr<FeatureDetector>(new GoodFeaturesToTrackDetector(1000,0.01,1.,3,false,0.04));
 }
 
 VideoProcessor::~VideoProcessor() {
+    discardPathModels();
 }
 
 void VideoProcessor::detectFeatures(Video* v, int radius) {
@@ -45,33 +121,16 @@ void VideoProcessor::detectFeatures(Video* v, int radius) {
     int frameCount = v->getFrameCount();
     int numFeaturesDetected = 0;
     vector<KeyPoint> bufferPoints;
+    Mat edgeMask = buildEdgeMask(v->getSize());
     for (int i = 0; i < frameCount; i++) {
         qDebug() << "VideoProcessor::detectFeatures - Detecting features in frame " << i <<"/"<<frameCount-1;
         emit processProgressChanged((float)i/frameCount-1);
         Frame* frame = v->accessFrameAt(i);
         const Mat& data = frame->getOriginalData();
         if (frame->getFeature() != 0 && radius > 0){
-            // Build mask around salient feature
             qDebug() << "VideoProcessor::detectFeatures - Only detecting features around the salient feature";
-            Point2f* point = frame->getFeature();
-            cv::Mat mask = Mat::zeros(data.size(), CV_8UC1);
-            for (int x = (point->x)-radius; x < (point->x)+radius; x++) {
-                for (int y = (point->y)-radius; y < (point->y)+radius; y++) {
-                    if (x >= 0 && x < mask.size().width && y >= 0 && y < mask.size().height) {
-                        mask.at<char>(Point2f(x,y)) = 1;
-                    }
-                }
-            }
-            featureDetector->detect(data, bufferPoints,mask);
-        } else {
-            cv::Mat edgeMask = Mat::zeros(data.size(), CV_8UC1);
-            for (int x = 2; x < v->getWidth()-7; x++) {
-                for (int y = 2; y < v->getHeight()-2; y++) {
-                    edgeMask.at<char>(Point2f(x,y)) = 1;
-                }
-            }
-            featureDetector->detect(data, bufferPoints, edgeMask);
         }
+        featureDetector->detect(data, bufferPoints, buildFeatureMask(frame, radius, edgeMask));
         vector<Point2f> features;
         KeyPoint::convert(bufferPoints, features);
         numFeaturesDetected += features.size();
@@ -110,7 +169,7 @@ void VideoProcessor::trackFeatures(Video* v) {
                 // Feature was tracked
                 featuresCorrectlyTracked++;
                 avgTrackedFeatures++;
-                Displacement d = Displacement(features[j], nextPositions[j]);
+                Displacement d = Displacement(features[j], nextPositions[j], err[j]);
                 frameT->registerDisplacement(d);
             }
         }
@@ -120,24 +179,102 @@ void VideoProcessor::trackFeatures(Video* v) {
     qDebug() << "VideoProcessor::trackFeatures - Avg tracked" << avgTrackedFeatures;
 }
 
+void VideoProcessor::analyseFramePairs(Video* v, int radius, bool keepDiagnostics) {
+    qDebug() << "VideoProcessor::analyseFramePairs - Fused analysis started";
+    discardPathModels();
+    Mat edgeMask = buildEdgeMask(v->getSize());
+    QThreadPool pool;
+    // Bound the number of frame pairs in flight so intermediate data stays small
+    QSemaphore available(2 * pool.maxThreadCount());
+    QAtomicInt completed(0);
+    int total = v->getFrameCount()-1;
+    for (int i = 1; i < v->getFrameCount(); i++) {
+        available.acquire();
+        pool.start(new FramePairTask(this, v, i, radius, edgeMask, keepDiagnostics, available, completed));
+        emit processProgressChanged(float(completed.load())/total);
+    }
+    while (!pool.waitForDone(50)) {
+        emit processProgressChanged(float(completed.load())/total);
+    }
+    emit processProgressChanged(1);
+    qDebug() << "VideoProcessor::analyseFramePairs - Original motion detected";
+}
+
+void VideoProcessor::analyseFramePair(Video* v, int frameNumber, int radius, const Mat& edgeMask, bool keepDiagnostics) {
+    Frame* frame = v->accessFrameAt(frameNumber);
+    const Frame* prevFrame = v->getFrameAt(frameNumber-1);
+    const Mat& data = frame->getOriginalData();
+
+    // Detect
+    vector<KeyPoint> keyPoints;
+    featureDetector->detect(data, keyPoints, buildFeatureMask(frame, radius, edgeMask));
+    vector<Point2f> features;
+    KeyPoint::convert(keyPoints, features);
+
+    // Track
+    vector<Point2f> nextPositions;
+    vector<uchar> status;
+    vector<float> err;
+    if (!features.empty()) {
+        calcOpticalFlowPyrLK(data, prevFrame->getOriginalData(), features, nextPositions, status, err);
+    }
+    vector<Point2f> from, to;
+    vector<float> errors;
+    for (uint j = 0; j < features.size(); j++) {
+        if (status[j] != 0) {
+            from.push_back(features[j]);
+            to.push_back(nextPositions[j]);
+            errors.push_back(err[j]);
+        }
+    }
+
+    // Reject
+    vector<uchar> mask;
+    if (!from.empty()) {
+        outlierRejector->process(frame->getSize(), from, to, errors, mask);
+    }
+    vector<Point2f> inlierFrom, inlierTo;
+    vector<float> inlierErrors;
+    vector<Displacement> outliers;
+    for (uint j = 0; j < from.size(); j++) {
+        if (mask[j] == 1) {
+            inlierFrom.push_back(from[j]);
+            inlierTo.push_back(to[j]);
+            inlierErrors.push_back(errors[j]);
+        } else if (keepDiagnostics) {
+            outliers.push_back(Displacement(from[j], to[j], errors[j]));
+        }
+    }
+
+    // Estimate
+    Matx23f affine;
+    Mat result(affine, false);
+    motionEstimator.estimate(inlierFrom, inlierTo, inlierErrors, result, frameNumber);
+    frame->setAffineTransform(result);
+
+    if (keepDiagnostics) {
+        frame->setFeatures(features);
+        for (uint j = 0; j < from.size(); j++) {
+            frame->registerDisplacement(Displacement(from[j], to[j], errors[j]));
+        }
+        frame->registerOutliers(outliers);
+    }
+}
+
 void VideoProcessor::rejectOutliers(Video* v) {
-    outlierRejector.execute(v);
+    outlierRejector->execute(v);
 }
 
 void VideoProcessor::calculateMotionModel(Video* v) {
     qDebug() << "VideoProcessor::calculateMotionModel - Calculating original motion";
+    discardPathModels();
+    // Each frame pair is independent, the estimate is written straight into the frame
+    QAtomicInt completed(0);
+    QList<QRunnable*> tasks;
     for (int i = 1; i < v->getFrameCount(); i++) {
-        emit processProgressChanged(float(i-1)/v->getFrameCount()-1);
-        Frame* frame = v->accessFrameAt(i);
-        vector<Point2f> srcPoints, destPoints;
-        frame->getInliers(srcPoints,destPoints);
-        // Weight towards salient point
-        // Estimate Rigid Transform DOES RANSAC too!
-        Mat affineTransform = videostab::estimateGlobalMotionRobust(srcPoints, destPoints);
-        Mat smallTransform = affineTransform.rowRange(0, affineTransform.rows-1);
-        //Mat affineTransform = estimateRigidTransform(srcPoints, destPoints, true);
-        frame->setAffineTransform(smallTransform.clone());
+        tasks.append(new MotionModelTask(motionEstimator, v->accessFrameAt(i), i, completed));
     }
+    runTasks(tasks, completed);
     qDebug() << "VideoProcessor::calculateMotionModel - Original motion detected";
 //    videostab::PyrLkRobustMotionEstimator motionEstimator;
 //    motionEstimator.setDetector(Ptr<FeatureDetector>(new GoodFeaturesToTrackDetector()));
@@ -154,25 +291,39 @@ void VideoProcessor::calculateMotionModel(Video* v) {
 
 void VideoProcessor::calculateSalientUpdateTransform(Video * video, bool centered) {
     qDebug() << "VideoProcessor::calculateSalientUpdateTransform - Start";
-    // Build model
-    L1SalientModel model(6);
-    model.prepare(video, centered);
-    emit processProgressChanged(1.0f/3);
-    qDebug() << "VideoProcessor::calculateSalientUpdateTransform - Solving L1 Problem";
-    // Solve model
-    model.solve();
+    if (hasPathModel(video, salientPathModel)) {
+        qDebug() << "VideoProcessor::calculateSalientUpdateTransform - Updating previous L1 Problem";
+        salientPathModel->updateCropBox(video->getCropBox(), video->getWidth(), video->getHeight());
+        salientPathModel->updateSalientBounds(video->getCropBox(), centered);
+        emit processProgressChanged(1.0f/3);
+        salientPathModel->resolve();
+        saveCachedPath(video, *salientPathModel, true, centered);
+    } else {
+        // Build model
+        discardPathModels();
+        salientPathModel = new L1SalientModel(motionEstimator.getDOF());
+        configureSolver(*salientPathModel);
+        pathModelVideo = video;
+        pathModelDOF = motionEstimator.getDOF();
+        if (!loadCachedPath(video, *salientPathModel, true, centered)) {
+            salientPathModel->prepare(video, centered);
+            emit processProgressChanged(1.0f/3);
+            qDebug() << "VideoProcessor::calculateSalientUpdateTransform - Solving L1 Problem";
+            // Solve model
+            salientPathModel->solve();
+            saveCachedPath(video, *salientPathModel, true, centered);
+        }
+    }
     emit processProgressChanged(2.0f/3);
     // Extract Results
     for (int t = 1; t < video->getFrameCount(); t++)
     {
-        Mat w = Mat::zeros(2,3,DataType<float>::type);
+        Matx23f w;
         for (char letter = 'a'; letter <= 'f'; letter++) {
-            w.at<float>(L1Model::toRow(letter),L1Model::toCol(letter)) = model.getVariableSolution(t, letter);
+            w(L1Model::toRow(letter),L1Model::toCol(letter)) = salientPathModel->getVariableSolution(t, letter);
         }
         Frame* f = video->accessFrameAt(t);
-        Mat b;
-        cv::invertAffineTransform(w, b);
-        f->setUpdateTransform(b.clone());
+        f->setUpdateTransform(Mat(Tools::invertAffine(w), false));
     }
     emit processProgressChanged(1);
     qDebug() << "VideoProcessor::calculateSalientUpdateTransform - Ideal Path Calculated";
@@ -180,51 +331,191 @@ void VideoProcessor::calculateSalientUpdateTransform(Video * video, bool centere
 
 void VideoProcessor::calculateUpdateTransform(Video* video) {
     qDebug() << "VideoProcessor::calculateUpdateTransform - Start";
-    // Build model
-    L1Model model(6);
-    model.prepare(video);
-    emit processProgressChanged(1.0f/3);
-    // Solve model
+    int frameCount = video->getFrameCount();
+    bool windowed = pathWindowSize > 0 && frameCount-1 > pathWindowSize;
+    if (motionEstimator.getMotionModel() == MotionEstimator::TRANSLATION) {
+        // Separates into one exactly solvable problem per axis, no LP needed
+        discardPathModels();
+        solvePathWindows<L1TranslationModel>(video);
+    } else if (bandedPathSolver) {
+        discardPathModels();
+        solvePathWindows<L1BandedModel>(video);
+    } else if (windowed) {
+        // Windows are rebuilt every time, only a whole video problem is kept
+        discardPathModels();
+        solvePathWindows<L1Model>(video);
+    } else {
+        if (hasPathModel(video, pathModel)) {
+            qDebug() << "VideoProcessor::calculateUpdateTransform - Updating previous L1 Problem";
+            pathModel->updateCropBox(video->getCropBox(), video->getWidth(), video->getHeight());
+            emit processProgressChanged(1.0f/3);
+            pathModel->resolve();
+            saveCachedPath(video, *pathModel, false, false);
+        } else {
+            // Build model
+            discardPathModels();
+            pathModel = new L1Model(motionEstimator.getDOF());
+            configureSolver(*pathModel);
+            pathModelVideo = video;
+            pathModelDOF = motionEstimator.getDOF();
+            if (!loadCachedPath(video, *pathModel, false, false)) {
+                pathModel->prepare(video);
+                emit processProgressChanged(1.0f/3);
+                // Solve model
+                pathModel->solve();
+                saveCachedPath(video, *pathModel, false, false);
+            }
+        }
+        emit processProgressChanged(2.0f/3);
+        // Extract Results
+        extractUpdateTransforms(video, *pathModel, 1, frameCount);
+    }
+    emit processProgressChanged(1);
+    qDebug() << "VideoProcessor::calculateUpdateTransform - Ideal Path Calculated";
+}
+
+// Each window keeps the frames up to its overlap with the next one.
+// The next window starts at the last kept frame and is anchored
+// to its solution, so the path stays continuous across windows.
+// Without a window size the whole video is a single window
+template <class Model>
+void VideoProcessor::solvePathWindows(Video* video) {
+    int frameCount = video->getFrameCount();
+    int windowSize = pathWindowSize > 0 ? pathWindowSize : frameCount-1;
+    Mat anchor = (Mat_<float>(2,3) << 1, 0, 0, 0, 1, 0);
+    int first = 1;
+    while (true) {
+        emit processProgressChanged(float(first)/frameCount);
+        int count = std::min(windowSize, frameCount-first);
+        bool last = first+count >= frameCount;
+        qDebug() << "VideoProcessor::solvePathWindows - Solving frames" << first << "to" << first+count-1;
+        Model model(motionEstimator.getDOF());
+        configureSolver(model);
+        model.setAnchor(anchor);
+        model.prepare(video, first, count);
+        model.solve();
+        int end = last ? frameCount : first+count-pathWindowOverlap;
+        extractUpdateTransforms(video, model, first, end);
+        if (last) {
+            break;
+        }
+        anchor = video->getFrameAt(end-1)->getUpdateTransform().clone();
+        first = end-1;
+    }
+}
+
+void VideoProcessor::solvePathHorizon(Video* video, int first, int count, const Mat& anchor) {
+    if (motionEstimator.getMotionModel() == MotionEstimator::TRANSLATION) {
+        solveHorizon<L1TranslationModel>(video, first, count, anchor);
+    } else if (bandedPathSolver) {
+        solveHorizon<L1BandedModel>(video, first, count, anchor);
+    } else {
+        solveHorizon<L1Model>(video, first, count, anchor);
+    }
+}
+
+template <class Model>
+void VideoProcessor::solveHorizon(Video* video, int first, int count, const Mat& anchor) {
+    Model model(motionEstimator.getDOF());
+    configureSolver(model);
+    model.setAnchor(anchor);
+    model.prepare(video, first, count);
+    startHorizon(model); // Ignored by the solve unless the horizon kept its size
     model.solve();
-    emit processProgressChanged(2.0f/3);
-    // Extract Results
-    for (int t = 1; t < video->getFrameCount(); t++)
+    finishHorizon(model);
+    extractUpdateTransforms(video, model, first, first+count);
+}
+
+// Models restored from the path cache have no problem loaded to update
+bool VideoProcessor::hasPathModel(Video* video, const L1Model* model) const {
+    return model != 0 && model->isLoaded() && pathModelVideo == video && pathModelDOF == motionEstimator.getDOF();
+}
+
+// Restores the solution of an identical problem if one was cached. Otherwise
+// the model is given the last basis of a problem of the same shape to start from
+bool VideoProcessor::loadCachedPath(Video* video, L1Model& model, bool salient, bool centered) {
+    if (!pathCache.isEnabled()) {
+        return false;
+    }
+    int dof = motionEstimator.getDOF();
+    vector<double> columns;
+    if (pathCache.loadSolution(PathCache::problemKey(video, dof, salient, centered), columns)) {
+        model.setLayout(1, video->getFrameCount()-1);
+        // A file left by a build with a different layout is a miss, not an error
+        if ((int) columns.size() == model.getWidth()) {
+            qDebug() << "VideoProcessor::loadCachedPath - Using cached solution";
+            model.setColumnSolution(columns);
+            return true;
+        }
+        qDebug() << "VideoProcessor::loadCachedPath - Ignoring a cached solution of" << columns.size()
+                 << "columns for a problem of" << model.getWidth();
+    }
+    vector<unsigned char> basis;
+    if (pathCache.loadBasis(PathCache::shapeKey(video, dof, salient), basis)) {
+        model.setWarmStart(basis);
+    }
+    return false;
+}
+
+void VideoProcessor::saveCachedPath(Video* video, L1Model& model, bool salient, bool centered) {
+    if (!pathCache.isEnabled()) {
+        return;
+    }
+    int dof = motionEstimator.getDOF();
+    pathCache.save(PathCache::problemKey(video, dof, salient, centered), PathCache::shapeKey(video, dof, salient),
+                   model.getColumnSolution(), model.getBasis());
+}
+
+void VideoProcessor::setPathCacheDirectory(const QString& directory) {
+    pathCache.setDirectory(directory);
+    qDebug() << "VideoProcessor - caching camera paths in" << directory;
+}
+
+void VideoProcessor::discardPathModels() {
+    delete pathModel;
+    delete salientPathModel;
+    pathModel = 0;
+    salientPathModel = 0;
+    pathModelVideo = 0;
+    horizonBasis.clear();
+}
+
+template <class Model>
+void VideoProcessor::extractUpdateTransforms(Video* video, Model& model, int first, int last) {
+    for (int t = first; t < last; t++)
     {
-        Mat m = Mat::zeros(2,3,DataType<float>::type);
+        Matx23f m;
         for (char letter = 'a'; letter <= 'f'; letter++) {
-            m.at<float>(L1Model::toRow(letter),L1Model::toCol(letter)) = model.getVariableSolution(t, letter);
+            m(L1Model::toRow(letter),L1Model::toCol(letter)) = model.getVariableSolution(t, letter);
         }
         Frame* f = video->accessFrameAt(t);
-        f->setUpdateTransform(m);
+        // Copied by the frame, so the Mat can share m
+        f->setUpdateTransform(Mat(m, false));
     }
-    emit processProgressChanged(1);
-    qDebug() << "VideoProcessor::calculateUpdateTransform - Ideal Path Calculated";
 }
 
 void VideoProcessor::applyCropTransform(Video* originalVideo, Video* croppedVideo)
 {
-    qDebug() << "VideoProcessor::applyCropTransform() - Started";
-    Rect cropWindow = originalVideo->getCropBox();
-    for (int f = 0; f < originalVideo->getFrameCount(); f++) {
-        emit processProgressChanged(float(f)/originalVideo->getFrameCount());
-        const Frame* frame = originalVideo->getFrameAt(f);
-        const Mat& img = frame->getOriginalData();
-        //Move cropWindow from current position to next position using frame's update transform
-        //Extract rectangle
-        Mat croppedImage;
-        if (f == 0) {
-            croppedImage = img(cropWindow);
-        } else {
-            // Rotate Crop Window
-            RotatedRect newCropWindow = Tools::transformRectangle(frame->getUpdateTransform(), cropWindow);
-            // Crop original video using Rotated Crop Window
-            croppedImage = Tools::getCroppedImage(img,newCropWindow);
-            resize(croppedImage, croppedImage, originalVideo->getCropBox().size());
-        }
-        Frame* croppedF = new Frame(croppedImage, croppedVideo);
-        croppedVideo->appendFrame(croppedF);
-    }
-    qDebug() << "VideoProcessor::applyCropTransform() - Finished";
+    VideoSink sink(croppedVideo);
+    renderCrops(originalVideo, sink);
+}
+
+void VideoProcessor::renderCrops(Video* originalVideo, FrameSink& sink)
+{
+    ExportPlanner planner;
+    QObject::connect(&planner, SIGNAL(processProgressChanged(float)), this, SIGNAL(processProgressChanged(float)));
+    planner.setInterpolation(interpolation);
+    planner.addVideo(ExportPlanner::STABILISED, &sink);
+    planner.run(originalVideo);
+}
+
+// Output pixel p is sampled at update*(p + crop origin), so the update transform
+// and the crop offset combine into one warp straight into a crop sized image
+Mat VideoProcessor::cropImage(const Mat& image, const Mat& update, const Rect& cropWindow, int interpolation) {
+    Matx23f warp = Tools::composeAffine(Matx23f(update), Tools::translationAffine(cropWindow.x, cropWindow.y));
+    Mat croppedImage;
+    warpAffine(image, croppedImage, Mat(warp, false), cropWindow.size(), interpolation | WARP_INVERSE_MAP);
+    return croppedImage;
 }
 
 void VideoProcessor::setGFTTDetector() {
@@ -251,3 +542,227 @@ void VideoProcessor::setGFTTHDetector() {
     featureDetector = FeatureDetector::create("HARRIS");
     qDebug() << "VideoProcessor - using Good Features To Track (With Harris Corner Detector) Feature Detector";
 }
+
+bool VideoProcessor::setPathWindow(int windowSize, int overlap) {
+    // Every window has to keep at least one frame past its anchor, or the next
+    // window would start where this one did
+    if (windowSize < 0 || (windowSize > 0 && (overlap < 0 || overlap >= windowSize-1))) {
+        qWarning() << "Invalid path window of" << windowSize << "frames with an overlap of" << overlap;
+        return false;
+    }
+    pathWindowSize = windowSize;
+    pathWindowOverlap = overlap;
+    qDebug() << "VideoProcessor - path window of" << windowSize << "frames with an overlap of" << overlap;
+    return true;
+}
+
+void VideoProcessor::setClpPathSolver() {
+    bandedPathSolver = false;
+    qDebug() << "VideoProcessor - using Clp to solve the camera path";
+}
+
+void VideoProcessor::setBandedPathSolver() {
+    bandedPathSolver = true;
+    qDebug() << "VideoProcessor - using the banded ADMM solver for the camera path";
+}
+
+void VideoProcessor::setNearestInterpolation() {
+    interpolation = INTER_NEAREST;
+    qDebug() << "VideoProcessor - using nearest neighbour interpolation";
+}
+
+void VideoProcessor::setBilinearInterpolation() {
+    interpolation = INTER_LINEAR;
+    qDebug() << "VideoProcessor - using bilinear interpolation";
+}
+
+void VideoProcessor::setBicubicInterpolation() {
+    interpolation = INTER_CUBIC;
+    qDebug() << "VideoProcessor - using bicubic interpolation";
+}
+
+void VideoProcessor::setLanczosInterpolation() {
+    interpolation = INTER_LANCZOS4;
+    qDebug() << "VideoProcessor - using Lanczos interpolation";
+}
+
+// Each frame is rendered once per interpolation on this thread, so the timings
+// compare the interpolations alone and the bicubic render is never stored
+void VideoProcessor::benchmarkInterpolation(Video* video) {
+    qDebug() << "VideoProcessor::benchmarkInterpolation - Start";
+    const int tiers[] = {INTER_NEAREST, INTER_LINEAR, INTER_CUBIC, INTER_LANCZOS4};
+    const char* names[] = {"Nearest", "Bilinear", "Bicubic", "Lanczos"};
+    const int tierCount = 4;
+    const int reference = 2;
+    qint64 time[tierCount] = {0};
+    double squaredError[tierCount] = {0};
+    const Rect& cropBox = video->getCropBox();
+    int frames = video->getFrameCount()-1;
+    QElapsedTimer timer;
+    for (int f = 1; f <= frames; f++) {
+        const Frame* frame = video->getFrameAt(f);
+        Mat rendered[tierCount];
+        for (int t = 0; t < tierCount; t++) {
+            timer.start();
+            rendered[t] = cropImage(frame->getOriginalData(), frame->getUpdateTransform(), cropBox, tiers[t]);
+            time[t] += timer.nsecsElapsed();
+        }
+        for (int t = 0; t < tierCount; t++) {
+            double error = norm(rendered[t], rendered[reference], NORM_L2);
+            squaredError[t] += error * error / rendered[t].total() / rendered[t].channels();
+        }
+        emit processProgressChanged(float(f)/frames);
+    }
+    for (int t = 0; t < tierCount; t++) {
+        double fps = time[t] > 0 ? frames * 1e9 / time[t] : 0;
+        double mse = squaredError[t] / std::max(frames, 1);
+        QString psnr;
+        if (t == reference) {
+            psnr = "reference";
+        } else if (mse > 0) {
+            psnr = QString::number(10 * log10(255.0 * 255.0 / mse), 'f', 2) + " dB";
+        } else {
+            psnr = "identical";
+        }
+        qWarning() << names[t] << "-" << fps << "frames per second, PSNR" << psnr;
+    }
+}
+
+double VideoProcessor::compareSolvers(Video* video) {
+    qDebug() << "VideoProcessor::compareSolvers - Start";
+    int dof = motionEstimator.getDOF();
+    QElapsedTimer timer;
+    timer.start();
+    L1Model clp(dof);
+    configureSolver(clp);
+    clp.prepare(video);
+    clp.solve();
+    qint64 clpTime = timer.restart();
+    L1BandedModel banded(dof);
+    configureSolver(banded);
+    banded.prepare(video);
+    bool converged = banded.solve();
+    qint64 bandedTime = timer.elapsed();
+
+    double clpObjective = clp.getObjectiveValue();
+    double bandedObjective = banded.getObjectiveValue();
+    double gap = fabs(bandedObjective - clpObjective) / std::max(fabs(clpObjective), 1.0);
+    double maxDifference = 0;
+    for (int t = 1; t < video->getFrameCount(); t++) {
+        for (char letter = 'a'; letter <= 'f'; letter++) {
+            maxDifference = std::max(maxDifference, fabs(clp.getVariableSolution(t, letter) - banded.getVariableSolution(t, letter)));
+        }
+    }
+    qWarning() << "Clp objective" << clpObjective << "in" << clpTime << "ms";
+    qWarning() << "Banded objective" << bandedObjective << "in" << bandedTime << "ms," << banded.getIterations() << "iterations" << (converged ? "" : "(not converged)");
+    qWarning() << "Relative objective gap" << gap << ", largest parameter difference" << maxDifference;
+    return gap;
+}
+
+void VideoProcessor::setSolverStrategy(L1Model::Strategy strategy) {
+    solverStrategy = strategy;
+    // So the next solve starts from scratch with the new settings
+    discardPathModels();
+}
+
+void VideoProcessor::setSolverScaling(int scaling) {
+    solverScaling = scaling;
+    discardPathModels();
+}
+
+void VideoProcessor::setSolverPresolve(bool presolve) {
+    solverPresolve = presolve;
+    discardPathModels();
+}
+
+void VideoProcessor::setBandedTolerance(double tolerance) {
+    bandedTolerance = tolerance;
+    qDebug() << "VideoProcessor - banded solver tolerance" << tolerance;
+}
+
+void VideoProcessor::configureSolver(L1Model& model) const {
+    model.setStrategy(solverStrategy);
+    model.setScaling(solverScaling);
+    model.setPresolve(solverPresolve);
+}
+
+void VideoProcessor::configureSolver(L1BandedModel& model) const {
+    model.setTolerance(bandedTolerance);
+}
+
+void VideoProcessor::setLocalRejector() {
+    setOutlierRejector(new LocalRANSACRejector(this));
+    qDebug() << "VideoProcessor - using fixed grid Local RANSAC Outlier Rejector";
+}
+
+void VideoProcessor::setHierarchicalRejector() {
+    setOutlierRejector(new HierarchicalRANSACRejector(this));
+    qDebug() << "VideoProcessor - using Hierarchical RANSAC Outlier Rejector";
+}
+
+void VideoProcessor::setRobustMotionEstimation() {
+    motionEstimator.setMethod(MotionEstimator::ROBUST);
+    qDebug() << "VideoProcessor - using RANSAC for global motion estimation";
+}
+
+void VideoProcessor::setLeastSquaresMotionEstimation() {
+    motionEstimator.setMethod(MotionEstimator::LEAST_SQUARES);
+    qDebug() << "VideoProcessor - using weighted least squares for global motion estimation";
+}
+
+void VideoProcessor::setTranslationModel() {
+    motionEstimator.setMotionModel(MotionEstimator::TRANSLATION);
+    qDebug() << "VideoProcessor - using translation motion model";
+}
+
+void VideoProcessor::setSimilarityModel() {
+    motionEstimator.setMotionModel(MotionEstimator::SIMILARITY);
+    qDebug() << "VideoProcessor - using similarity motion model";
+}
+
+void VideoProcessor::setAffineModel() {
+    motionEstimator.setMotionModel(MotionEstimator::AFFINE);
+    qDebug() << "VideoProcessor - using affine motion model";
+}
+
+void VideoProcessor::setOutlierRejector(OutlierRejector* rejector) {
+    delete outlierRejector;
+    outlierRejector = rejector;
+    QObject::connect(outlierRejector, SIGNAL(processProgressChanged(float)), this, SIGNAL(processProgressChanged(float)));
+}
+
+void VideoProcessor::runTasks(const QList<QRunnable*>& tasks, const QAtomicInt& completed) {
+    QThreadPool pool;
+    for (int i = 0; i < tasks.size(); i++) {
+        pool.start(tasks[i]);
+    }
+    // Tasks are deleted by the pool, only the count is used from here on
+    int total = tasks.size();
+    while (!pool.waitForDone(50)) {
+        emit processProgressChanged(float(completed.load())/total);
+    }
+    emit processProgressChanged(1);
+}
+
+Mat VideoProcessor::buildEdgeMask(Size size) {
+    cv::Mat edgeMask = Mat::zeros(size, CV_8UC1);
+    Rect inner(2, 2, size.width-9, size.height-4);
+    if (inner.width > 0 && inner.height > 0) {
+        edgeMask(inner).setTo(1);
+    }
+    return edgeMask;
+}
+
+Mat VideoProcessor::buildFeatureMask(Frame* frame, int radius, const Mat& edgeMask) {
+    if (frame->getFeature() == 0 || radius <= 0) {
+        return edgeMask;
+    }
+    // Only search the window around the salient feature
+    Point2f* point = frame->getFeature();
+    cv::Mat mask = Mat::zeros(edgeMask.size(), CV_8UC1);
+    Rect window = Rect(int(point->x)-radius, int(point->y)-radius, 2*radius, 2*radius) & Rect(0, 0, mask.cols, mask.rows);
+    if (window.area() > 0) {
+        mask(window).setTo(1);
+    }
+    return mask;
+}
@@ -3,12 +3,23 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QRunnable>
+#include <QAtomicInt>
 #include "video.h"
 #include "opencv2/core/core.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
 #include "opencv2/features2d/features2d.hpp"
 #include "opencv2/video/video.hpp"
+#include "outlierrejector.h"
 #include "localransacrejector.h"
 #include "ransacmodel.h"
+#include "motionestimator.h"
+#include "l1model.h"
+#include "l1salientmodel.h"
+#include "l1bandedmodel.h"
+#include "l1translationmodel.h"
+#include "pathcache.h"
+#include "framesink.h"
 #include <string>
 using namespace std;
 
@@ -39,6 +50,11 @@ public slots:
     void trackFeatures(Video* v);
     void rejectOutliers(Video* v);
 
+    // Detects, tracks, rejects outliers and estimates the motion of each frame pair
+    // back to back on a pool of worker threads, instead of four passes over the video.
+    // Only the affine transformations are kept unless keepDiagnostics is set
+    void analyseFramePairs(Video* v, int radius, bool keepDiagnostics);
+
     // Estimates and sets the affine transformation for each frame pair
     // Pre: Frames contain a list of tracked points
     // Post: Frame's affine transformation Mat is set
@@ -59,13 +75,130 @@ public slots:
     void setSIFTDetector();
     void setFASTDetector();
     void setGFTTHDetector();
+    void setLocalRejector();
+    void setHierarchicalRejector();
+    void setRobustMotionEstimation();
+    void setLeastSquaresMotionEstimation();
+    void setTranslationModel();
+    void setSimilarityModel();
+    void setAffineModel();
+
+    // Solves the path in overlapping windows of windowSize frames once the video
+    // is longer than that, so memory and solve time grow linearly with its length.
+    // A windowSize of 0 always solves the whole video at once. Returns false, keeping
+    // the previous setting, unless every window keeps a frame past its anchor
+    bool setPathWindow(int windowSize, int overlap);
+
+    // Solves the (non salient) path with Clp or with the banded ADMM solver
+    void setClpPathSolver();
+    void setBandedPathSolver();
+
+    // Interpolation used to render the new frames, from fastest to sharpest
+    void setNearestInterpolation();
+    void setBilinearInterpolation();
+    void setBicubicInterpolation();
+    void setLanczosInterpolation();
+
+    // Solved whole video paths are cached in this directory, empty disables the cache
+    void setPathCacheDirectory(const QString& directory);
+
+    // LP settings used by the Clp path solvers
+    void setSolverStrategy(L1Model::Strategy strategy);
+    void setSolverScaling(int scaling);
+    void setSolverPresolve(bool presolve);
+
+    // Residual per row at which the banded ADMM solver stops, 1e-3 by default
+    void setBandedTolerance(double tolerance);
+
+    // Solves the path of the video with both solvers and reports their objective
+    // values and timings. Returns the relative gap between the objectives
+    double compareSolvers(Video* v);
+
+    // Renders the new video with every interpolation and reports the frames rendered
+    // per second and the PSNR against the bicubic render of each
+    // Pre: the update transforms of the video are set
+    void benchmarkInterpolation(Video* v);
+
+
+public:
+    // Forgets the solved path models. Must be called whenever the frame motions
+    // or the salient features of the video they were built from change
+    void discardPathModels();
+
+    // A single step of analyseFramePairs, safe to call concurrently for different frames
+    void analyseFramePair(Video* v, int frameNumber, int radius, const Mat& edgeMask, bool keepDiagnostics);
+
+    // Sets the update transforms of frames [first, first+count) with frame first fixed
+    // to anchor. Successive calls over a horizon that slides by one frame warm start
+    // from the previous solve
+    void solvePathHorizon(Video* v, int first, int count, const Mat& anchor);
+
+    // Mask of the border excluded when detecting features
+    static Mat buildEdgeMask(Size size);
+
+    // Renders the crop of every frame moved by its update transform into the sink,
+    // in frame order. The rendered frames are not kept
+    void renderCrops(Video* originalVideo, FrameSink& sink);
+
+    // Extracts the crop window moved by the update transform, at the size of the crop window
+    static Mat cropImage(const Mat& image, const Mat& update, const Rect& cropWindow, int interpolation = INTER_CUBIC);
 
+    int getInterpolation() const {return interpolation;}
 
 private:
     mutable QMutex mutex;
 
     Ptr<FeatureDetector> featureDetector;
-    LocalRANSACRejector outlierRejector;
+    OutlierRejector* outlierRejector;
+    MotionEstimator motionEstimator;
+    int pathWindowSize;
+    int pathWindowOverlap;
+    bool bandedPathSolver;
+    L1Model::Strategy solverStrategy;
+    int solverScaling;
+    bool solverPresolve;
+    double bandedTolerance;
+    int interpolation;
+    void configureSolver(L1Model& model) const;
+    void configureSolver(L1BandedModel& model) const;
+    void configureSolver(L1TranslationModel&) const {}
+
+    // The last solved path models. When only the crop box or the salient
+    // options change, their bounds are updated and they are re-solved
+    // from the previous optimal basis instead of being rebuilt
+    L1Model* pathModel;
+    L1SalientModel* salientPathModel;
+    Video* pathModelVideo;
+    int pathModelDOF;
+    bool hasPathModel(Video* video, const L1Model* model) const;
+
+    PathCache pathCache;
+    bool loadCachedPath(Video* video, L1Model& model, bool salient, bool centered);
+    void saveCachedPath(Video* video, L1Model& model, bool salient, bool centered);
+
+    void setOutlierRejector(OutlierRejector* rejector);
+
+    // Solves the path window by window with a fresh model of the given type
+    template <class Model> void solvePathWindows(Video* video);
+
+    // Sets the update transforms of frames [first, last) from a solved model
+    template <class Model> static void extractUpdateTransforms(Video* video, Model& model, int first, int last);
+
+    // Basis of the last horizon solved by solvePathHorizon, shifted one frame on
+    vector<unsigned char> horizonBasis;
+    template <class Model> void solveHorizon(Video* video, int first, int count, const Mat& anchor);
+    void startHorizon(L1Model& model) const {model.setWarmStart(horizonBasis);}
+    void startHorizon(L1BandedModel&) const {}
+    void startHorizon(L1TranslationModel&) const {}
+    void finishHorizon(L1Model& model) {horizonBasis = model.getShiftedBasis(1);}
+    void finishHorizon(L1BandedModel&) {}
+    void finishHorizon(L1TranslationModel&) {}
+
+    // Mask used when detecting features around a salient feature
+    static Mat buildFeatureMask(Frame* frame, int radius, const Mat& edgeMask);
+
+    // Runs the tasks on a pool of worker threads, reporting progress until all have finished
+    void runTasks(const QList<QRunnable*>& tasks, const QAtomicInt& completed);
 };
 
 #endif // VIDEOPROCESSOR_H
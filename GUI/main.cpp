@@ -31,6 +31,10 @@ int main(int argc, char *argv[])
     QObject::connect(&w, SIGNAL(surfRadioButtonPressed()), &app, SLOT(setSURFDetector()));
     QObject::connect(&w, SIGNAL(siftRadioButtonPressed()), &app, SLOT(setSIFTDetector()));
     QObject::connect(&w, SIGNAL(fastRadioButtonPressed()), &app, SLOT(setFASTDetector()));
+    QObject::connect(&w, SIGNAL(nearestRadioButtonPressed()), &app, SLOT(setNearestInterpolation()));
+    QObject::connect(&w, SIGNAL(bilinearRadioButtonPressed()), &app, SLOT(setBilinearInterpolation()));
+    QObject::connect(&w, SIGNAL(bicubicRadioButtonPressed()), &app, SLOT(setBicubicInterpolation()));
+    QObject::connect(&w, SIGNAL(lanczosRadioButtonPressed()), &app, SLOT(setLanczosInterpolation()));
     QObject::connect(&w, SIGNAL(exportDataToMatlabPressed(QString)), &app, SLOT(saveOriginalGlobalMotionMat(QString)));
     QObject::connect(&w, SIGNAL(exportDataToMatlabPressed(QString)), &app, SLOT(saveNewGlobalMotionMat(QString)));
     QObject::connect(&w, SIGNAL(saveOriginalFrameButtonPressed(QString, int, bool)), &app, SLOT(saveOriginalFrame(QString, int, bool)));
@@ -36,6 +36,7 @@ MainWindow::MainWindow(QWidget *parent) :
     outliersRejected = false;
     originalMotion = false;
     cropBox = false;
+    newVideo = 0;
 
     // Setup SIGNALS and SLOTS
     QObject::connect(player, SIGNAL(processedImage(QImage, int)),this, SLOT(updatePlayerUI(QImage, int)));
@@ -303,6 +304,8 @@ void MainWindow::registerOriginalVideo(Video* video)
     resetUI();
 
     originalVideo = video;
+    // Loading deleted the new video of the previous one
+    newVideo = 0;
     featuresDetected = false;
     featuresTracked = false;
     outliersRejected = false;
@@ -334,9 +337,19 @@ void MainWindow::registerOriginalVideo(Video* video)
 
 void MainWindow::registerNewVideo(Video* video)
 {
+    Video* previous = newVideo;
     newVideo = video;
-    ui->videoCombobox->addItem("New Video");
-    ui->videoCombobox->addItem("Both");
+    if (ui->videoCombobox->findText("New Video") == -1) {
+        ui->videoCombobox->addItem("New Video");
+        ui->videoCombobox->addItem("Both");
+    } else if (ui->videoCombobox->currentText() != "Original Video") {
+        player->setVideo(video);
+    }
+    // The core application stopped the previous video and left it to be deleted
+    // here, once nothing shows it
+    if (previous != 0) {
+        previous->deleteLater();
+    }
     ui->exportNewFrameButton->setEnabled(true);
 }
 
@@ -497,6 +510,26 @@ void MainWindow::on_fastRadioButton_clicked()
     emit fastRadioButtonPressed();
 }
 
+void MainWindow::on_nearestRadioButton_clicked()
+{
+    emit nearestRadioButtonPressed();
+}
+
+void MainWindow::on_bilinearRadioButton_clicked()
+{
+    emit bilinearRadioButtonPressed();
+}
+
+void MainWindow::on_bicubicRadioButton_clicked()
+{
+    emit bicubicRadioButtonPressed();
+}
+
+void MainWindow::on_lanczosRadioButton_clicked()
+{
+    emit lanczosRadioButtonPressed();
+}
+
 
 
 void MainWindow::on_exportDataToMatlabButton_clicked()
@@ -72,6 +72,10 @@ private slots:
     void on_siftRadioButton_clicked();
     void on_surfRadioButton_clicked();
     void on_fastRadioButton_clicked();
+    void on_nearestRadioButton_clicked();
+    void on_bilinearRadioButton_clicked();
+    void on_bicubicRadioButton_clicked();
+    void on_lanczosRadioButton_clicked();
 
     void on_exportDataToMatlabButton_clicked();
 
@@ -107,6 +111,10 @@ signals:
    void surfRadioButtonPressed();
    void siftRadioButtonPressed();
    void fastRadioButtonPressed();
+   void nearestRadioButtonPressed();
+   void bilinearRadioButtonPressed();
+   void bicubicRadioButtonPressed();
+   void lanczosRadioButtonPressed();
 
 
 protected:
@@ -60,7 +60,7 @@ void Player::showImage(int frameNumber)
         return;
     }
     const Frame* frame = video->getFrameAt(frameNumber);
-    const Mat& originalData = frame->getOriginalData();
+    Mat originalData = video->getImageAt(frameNumber);
     Mat image;
     if (featuresEnabled) {
         // Draw Features
@@ -70,8 +70,7 @@ void Player::showImage(int frameNumber)
     } else if (trackedEnabled && frameNumber > 0) {
         // Draw Tracked Features
         const vector<Displacement>& disps = frame->getDisplacements();
-        const Frame* prevFrame = video->getFrameAt(frameNumber-1);
-        const Mat& prevFrameImg = prevFrame->getOriginalData();
+        Mat prevFrameImg = video->getImageAt(frameNumber-1);
 //        vector<Point2f> features1, features2;
 //        vector<KeyPoint> featuresk1, featuresk2;
 //        vector<DMatch> matches;
@@ -104,8 +103,7 @@ void Player::showImage(int frameNumber)
         if (frameNumber == 0) {
             cv::rectangle(image, cropBox, Scalar(0,255,0), 3);
         } else {
-            const Mat& update = frame->getUpdateTransform();
-            RotatedRect newCrop = Tools::transformRectangle(update, cropBox);
+            RotatedRect newCrop = Tools::transformRectangle(Matx23f(frame->getUpdateTransform()), cropBox);
             Point2f verts[4];
             newCrop.points(verts);
             for (int i = 0; i < 4; i++) {
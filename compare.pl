@@ -0,0 +1,31 @@
+#!/usr/bin/perl
+
+#   Motion Solver Comparison Script
+#
+#   Solves the camera path of each example clip with both Clp and the
+#   banded ADMM solver at each tolerance and prints their objective values
+#   and timings.
+#   It must be run from the same directory as the MotionConsole executable
+#
+
+# Options
+$examples_dir = '../Examples/';
+@clips = ('Fake Heart/sheart50.avi', 'NYBMW/nybmw50.avi', 'BMW/BMW_50.avi', 'BMW/BMW.avi');
+@cropCorners = ('36,29', '48,27', '71,35', '71,35');
+@cropSizes = ('288,230', '384,216', '570,284', '570,284');
+@motionModels = ('translation', 'similarity', 'affine');
+@bandedTolerances = ('1e-2', '1e-3', '1e-4');
+
+
+# Main Program
+foreach $clipIndex (0..$#clips) {
+  foreach $model (@motionModels) {
+    $clip = $examples_dir . $clips[$clipIndex];
+    foreach $tolerance (@bandedTolerances) {
+      print "$clips[$clipIndex] ($model, banded tolerance $tolerance)\n";
+      $command = "./MotionConsole \"$clip\" -C $cropCorners[$clipIndex] -S $cropSizes[$clipIndex] -T $model --fused --compare-solvers --banded-tolerance $tolerance";
+      system($command);
+      print "\n";
+    }
+  }
+}
@@ -0,0 +1,24 @@
+#!/usr/bin/perl
+
+#   Interpolation Benchmark Script
+#
+#   Renders the stabilised video of each example clip with every
+#   interpolation and prints their throughput and PSNR against bicubic.
+#   It must be run from the same directory as the MotionConsole executable
+#
+
+# Options
+$examples_dir = '../Examples/';
+@clips = ('Fake Heart/sheart50.avi', 'NYBMW/nybmw50.avi', 'BMW/BMW_50.avi', 'BMW/BMW.avi');
+@cropCorners = ('36,29', '48,27', '71,35', '71,35');
+@cropSizes = ('288,230', '384,216', '570,284', '570,284');
+
+
+# Main Program
+foreach $clipIndex (0..$#clips) {
+  $clip = $examples_dir . $clips[$clipIndex];
+  print "$clips[$clipIndex]\n";
+  $command = "./MotionConsole \"$clip\" -C $cropCorners[$clipIndex] -S $cropSizes[$clipIndex] -T similarity --fused --benchmark-interpolation";
+  system($command);
+  print "\n";
+}
@@ -0,0 +1,27 @@
+#!/usr/bin/perl
+
+#   Online Latency Script
+#
+#   Replays each example clip at its native frame rate through the online
+#   stabiliser and prints the end to end latency for several look-aheads.
+#   It must be run from the same directory as the MotionConsole executable
+#
+
+# Options
+$examples_dir = '../Examples/';
+@clips = ('Fake Heart/sheart50.avi', 'NYBMW/nybmw50.avi', 'BMW/BMW_50.avi', 'BMW/BMW.avi');
+@cropCorners = ('36,29', '48,27', '71,35', '71,35');
+@cropSizes = ('288,230', '384,216', '570,284', '570,284');
+@latencies = (5, 15, 30);
+
+
+# Main Program
+foreach $clipIndex (0..$#clips) {
+  foreach $latency (@latencies) {
+    $clip = $examples_dir . $clips[$clipIndex];
+    print "$clips[$clipIndex] (latency $latency)\n";
+    $command = "./MotionConsole \"$clip\" online_output.avi -C $cropCorners[$clipIndex] -S $cropSizes[$clipIndex] -T similarity --online --latency $latency";
+    system($command);
+    print "\n";
+  }
+}
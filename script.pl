@@ -25,10 +25,13 @@ $output_dir = '/vol/bitbucket/osw09/HeartResults/';
 $manual_dir = '/homes/osw09/Motion/Examples/Heart/HeartManualMarkings';
 @salientTracking = (0,1);
 @gravitateToCenter = (0,1);
+# Runs that only differ in their output share solved camera paths through this cache
+$path_cache_dir = $output_dir . 'PathCache';
 
 
 # Main Program
 mkdir($output_dir);
+mkdir($path_cache_dir);
 $count = 1;
 foreach $cropIndex (0..$#cropCornerX) {
   $cropCorner = $cropCornerX[$cropIndex] . ',' . $cropCornerY[$cropIndex];
@@ -41,7 +44,7 @@ foreach $cropIndex (0..$#cropCornerX) {
       $dirHandle = dir($dir);
       $file = $dirHandle->file("info.txt");
       $file_handle = $file->openw();
-      $command = "./MotionConsole -I $input_video -O $dir/output.avi -C $cropCorner -S $cropSize -F $fdmethod -W $fdwindow -D";
+      $command = "./MotionConsole -I $input_video -O $dir/output.avi -C $cropCorner -S $cropSize -F $fdmethod -W $fdwindow --path-cache $path_cache_dir -D";
       $file_handle->print($command);
       $rc = system($command);
       if ($rc & 127) { die "signal death" } 
@@ -53,7 +56,7 @@ foreach $cropIndex (0..$#cropCornerX) {
         $dirHandle = dir($dir);
         $file = $dirHandle->file("info.txt");
         $file_handle = $file->openw();
-        $command = "./MotionConsole -I $input_video -O $dir/output.avi -C $cropCorner -S $cropSize -F $fdmethod -W $fdwindow --salient-path-tracking -M $manual_dir -G $gravitate -D";
+        $command = "./MotionConsole -I $input_video -O $dir/output.avi -C $cropCorner -S $cropSize -F $fdmethod -W $fdwindow --salient-path-tracking -M $manual_dir -G $gravitate --path-cache $path_cache_dir -D";
         $file_handle->print($command);
         $rc = system($command);
         if ($rc & 127) { die "signal death" }   